@@ -3,30 +3,144 @@ Copyright (c) 2013 Gauthier Fleutot Ostervall
 ----------------------------------------------------------------------------*/
 #include "linkedlist.h"
 
+#include "linkedlist_error.h"
+
 #include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if !defined(LINKEDLIST_NO_SIMD) && (defined(__SSE2__) || defined(__AVX2__))
+#include <immintrin.h>
+#endif
+
 typedef struct node_s {
     void const *data;       // Generic data type pointer.
+    struct intern_entry_s *entry;   // Shared data, NULL if owned by the node.
     struct node_s *next;
 } node_t;
 
+// Interned data, shared by refcount nodes. The refcount is atomic since the
+// nodes sharing an entry may be in lists used by different threads.
+typedef struct intern_entry_s {
+    void *data;
+    size_t hash;
+    unsigned long refcount;
+    linkedlist_intern_t *table;
+    struct intern_entry_s *next;    // Next in the same bucket.
+} intern_entry_t;
+
+// Hash table of the interned data, chained in buckets. The buckets are only
+// read or changed with the lock held, see intern_lock().
+struct linkedlist_intern_s {
+    size_t data_size;
+    size_t nb_buckets;      // A power of 2.
+    size_t nb_entries;
+    intern_entry_t **buckets;
+    int nb_lists;           // Lists interning their data in this table.
+    bool lock;
+};
+
 struct linkedlist_s {
     int size;
     node_t *head;
+    node_t *tail;
+    unsigned int capacity;  // 0 for a normal list, window size if circular.
+    unsigned long generation;   // Bumped on changes, to catch stale views.
+    size_t data_size;       // Size of one data, for accounting. 0 if unknown.
+    size_t budget;          // Max bytes of nodes and data, 0 for no limit.
+    linkedlist_group_t *group;  // NULL if not in a group.
+    struct summary_s *summary;  // Aggregate kept over the list, or NULL.
+    linkedlist_intern_t *intern;    // Table for new data, NULL to own them.
+};
+
+// Node of the summary treap, for one position of the list. The treap is
+// ordered by position, each node coming after those of its left subtree, and
+// is a max-heap on priority, which keeps it balanced with high probability.
+// values holds the mapped value of the position, then the aggregate of the
+// subtree. It follows priority, so that it is aligned like any value.
+typedef struct snode_s {
+    struct snode_s *left;
+    struct snode_s *right;
+    node_t const *node;     // List node of the position.
+    int size;               // Positions in the subtree.
+    unsigned long long priority;
+    unsigned char values[];
+} snode_t;
+
+// Aggregate kept over the positions of a list, in a treap (see snode_t). The
+// treap holds the positions [0, valid) only, valid being its size. The other
+// positions are mapped and joined to it by summary_update(), walking the list
+// from the node of position valid - 1, so that only the positions changed
+// since the last query are walked. The treap is cut and joined along with the
+// nodes when lists are spliced or rotated, so that moved nodes keep their
+// values.
+typedef struct summary_s {
+    linkedlist_aggregate_t aggregate;   // identity points to values below.
+    snode_t *root;          // NULL if no position is up to date.
+    unsigned char *values;  // Identity, then 1 value of scratch.
+} summary_t;
+
+// Memory growth of one of several lists changing together, see
+// budget_allows_many().
+typedef struct {
+    linkedlist_t const *list;
+    long long growth;
+} list_growth_t;
+
+// Range of consecutive positions whose data are held by a delta.
+typedef struct {
+    int start;
+    int count;
+    size_t offset;          // Of the data of start in the payloads.
+} delta_range_t;
+
+// Edit script turning a list of base_size elements into one of size elements.
+// The data at the positions of the ranges are replaced, or appended when past
+// the end. Ranges are sorted, and cover all positions from base_size to size.
+struct linkedlist_delta_s {
+    size_t data_size;
+    int base_size;
+    int size;
+    int nb_ranges;
+    int max_ranges;
+    delta_range_t *ranges;
+    size_t payloads_used;   // Bytes.
+    size_t payloads_max;
+    unsigned char *payloads;
+};
+
+struct linkedlist_group_s {
+    size_t budget;          // Max bytes of all the lists, 0 for no limit.
+    size_t memory;          // Bytes of all the lists in the group, atomic.
+    int nb_lists;           // Atomic.
 };
 
 //******************************************************************************
 // Module constants
 //******************************************************************************
 
+// First bytes of an encoded delta, ending with the format version.
+static unsigned char const delta_magic[4] = {'L', 'L', 'D', 1};
+// Largest data, and total of data, that an encoded delta may hold, so that a
+// corrupt header cannot make linkedlist_delta_read() reserve gigabytes.
+static unsigned long const delta_data_size_max = 1UL << 20;
+static unsigned long const delta_payloads_max = 1UL << 26;
+
 //******************************************************************************
 // Module variables
 //******************************************************************************
+static __thread linkedlist_status_t last_error = LINKEDLIST_OK;
+static linkedlist_log_hook_t log_hook = NULL;
+// Bytes of nodes and data of all lists. Updated atomically since different
+// threads may work on different lists.
+static size_t memory_total = 0;
+// Count behind the priorities of the summary treaps. Atomic, since lists of
+// different threads may exchange nodes.
+static unsigned long long priority_count = 0;
 
 //******************************************************************************
 // Function prototypes
@@ -34,12 +148,111 @@ struct linkedlist_s {
 static void nodes_recursive_destroy(node_t *node_p);
 static void nodes_run_for_all(node_t *node_p,
                               void (*callback)(void const * const data));
-static node_t *nodes_recursive_copy(node_t *src,
-                                    size_t const data_size);
+static node_t *nodes_find(node_t *node_p,
+                          linkedlist_visitor_t const visitor,
+                          void * const context,
+                          bool const until,
+                          int * const position);
+static bool nodes_recursive_copy(node_t *src,
+                                 size_t const data_size,
+                                 linkedlist_intern_t * const table,
+                                 node_t ** const copy);
 static bool nodes_recursive_compare(node_t * const a, node_t * const b,
                                     size_t const data_size);
 static node_t *nodes_walker(node_t * const start, int const pos);
+static node_t *nodes_last(node_t * const start);
+static node_t *list_walker(linkedlist_t const * const list, long const pos);
 static void length_limit(linkedlist_t * const list, int const limit);
+static int list_max_size(linkedlist_t const * const list);
+static void list_clear(linkedlist_t * const list);
+static void list_changed(linkedlist_t * const list, long const position);
+static void list_shifted(linkedlist_t * const list, int const k,
+                         bool const rotated);
+static snode_t *list_tail_detach(linkedlist_t * const list,
+                                 int const position);
+static void list_tail_attach(linkedlist_t * const list, int const position,
+                             summary_t const * const from,
+                             snode_t * const tail);
+static linkedlist_status_t summary_update(linkedlist_t * const list);
+static void summary_position_update(summary_t * const summary,
+                                    int const position);
+static bool aggregates_equal(linkedlist_aggregate_t const * const a,
+                             linkedlist_aggregate_t const * const b);
+static void summary_destroy(summary_t *summary);
+static snode_t *snode_create(summary_t * const summary,
+                             node_t const * const node);
+static int snode_size(snode_t const * const tree);
+static unsigned char *snode_total(summary_t const * const summary,
+                                  snode_t * const tree);
+static void snode_pull(summary_t * const summary, snode_t * const tree);
+static void snode_split(summary_t * const summary, snode_t * const tree,
+                        int const k, snode_t ** const left,
+                        snode_t ** const right);
+static snode_t *snode_join(summary_t * const summary, snode_t * const a,
+                           snode_t * const b);
+static void snode_update(summary_t * const summary, snode_t * const tree,
+                         int const position);
+static void snode_fold(summary_t * const summary, snode_t * const tree,
+                       int const start, int const end,
+                       unsigned char * const result);
+static void snode_destroy(snode_t *tree);
+static unsigned long long priority_next(void);
+static void view_check(linkedlist_view_t const * const view);
+static size_t list_memory(long const size, size_t const data_size);
+static size_t data_charge(linkedlist_t const * const list,
+                          size_t const data_size);
+static void memory_account(linkedlist_t * const list, long long const delta);
+static void list_size_set(linkedlist_t * const list, long const size);
+static long long memory_growth(linkedlist_t const * const list,
+                               long const new_size,
+                               size_t const new_data_size);
+static bool budget_allows(linkedlist_t const * const list,
+                          long long const growth,
+                          long long const group_growth);
+static linkedlist_status_t budget_allows_many(linkedlist_t * const lists[],
+                                              int const nb_lists,
+                                              long const new_size,
+                                              size_t const new_data_size);
+static int list_growth_compare(void const * const a, void const * const b);
+static linkedlist_status_t list_append(linkedlist_t * const dst,
+                                       node_t const * const payload);
+static node_t *list_unlink_head(linkedlist_t * const list);
+static bool nodes_differ(node_t const * const a, node_t const * const b,
+                         size_t const data_size);
+static bool node_data_copy(node_t * const to, node_t const * const from,
+                           size_t const data_size,
+                           linkedlist_intern_t * const table);
+static void node_data_release(node_t * const node);
+static bool node_unshare(node_t * const node);
+static size_t intern_hash(void const * const data, size_t const data_size);
+static intern_entry_t *intern_lookup(linkedlist_intern_t * const table,
+                                     void const * const data,
+                                     size_t const hash);
+static intern_entry_t *intern_insert(linkedlist_intern_t * const table,
+                                     void * const data,
+                                     size_t const hash);
+static intern_entry_t *intern_get(linkedlist_intern_t * const table,
+                                  void const * const data,
+                                  void * const adopted);
+static void intern_release(intern_entry_t * const entry);
+static void intern_lock(linkedlist_intern_t * const table);
+static void intern_unlock(linkedlist_intern_t * const table);
+static bool node_data_set(node_t * const to, node_t const * const from,
+                          size_t const data_size,
+                          linkedlist_intern_t * const table);
+static void delta_reset(linkedlist_delta_t * const delta,
+                        size_t const data_size,
+                        int const base_size,
+                        int const size);
+static unsigned char *delta_payload_reserve(linkedlist_delta_t * const delta,
+                                            int const position);
+static bool delta_range_check(linkedlist_delta_t const * const delta,
+                              long const start,
+                              long const count);
+static bool stream_u32_write(FILE * const stream, unsigned long const value);
+static bool stream_u32_read(FILE * const stream, unsigned long * const value);
+static bool payload_differs(void const * const a, void const * const b,
+                            size_t const data_size);
 
 //******************************************************************************
 // Function definitions
@@ -52,59 +265,117 @@ linkedlist_t *linkedlist_create(void)
 {
     linkedlist_t *new_list_p = malloc(sizeof (linkedlist_t));
     if (new_list_p == NULL) {
-        fprintf(stderr, "%s: new_list_p is NULL.\n", __func__);
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
         return NULL;
     }
     new_list_p->head = NULL;
+    new_list_p->tail = NULL;
     new_list_p->size = 0;
+    new_list_p->capacity = 0;
+    new_list_p->generation = 0;
+    new_list_p->data_size = 0;
+    new_list_p->budget = 0;
+    new_list_p->group = NULL;
+    new_list_p->summary = NULL;
+    new_list_p->intern = NULL;
     return new_list_p;
 }
 
 
 //  ----------------------------------------------------------------------------
-/// \brief  Add a new node at the end of a linked list, with content
-/// data. Allocate memory for the new node, walk through the list to its end,
-/// and link to the new node. If the list was empty before being added to, the
-/// new start of list is the new node itseld.
-/// \attention  The data object must be dynamically allocated since the list's
-/// destroy function uses free() on all data objects.
+/// \brief  Create a new empty circular list. Adding to a full circular list
+/// drops its head instead of the new element.
+/// \return Pointer to the new list.
 //  ----------------------------------------------------------------------------
-void linkedlist_add(linkedlist_t *dst, void const * const data)
+linkedlist_t *linkedlist_circular_create(unsigned int const capacity)
 {
-    if (dst == NULL) {
-        fprintf(stderr, "%s: the list needs to be created first.\n", __func__);
-        return;
+    linkedlist_t *new_list_p = linkedlist_create();
+    if (new_list_p == NULL) {
+        return NULL;
     }
-
-    if (dst->size >= LINKEDLIST_MAX_SIZE) {
-        // Max reached, which is not an error. Do nothing.
-        return;
+    if (capacity == 0 || capacity > LINKEDLIST_MAX_SIZE) {
+        new_list_p->capacity = LINKEDLIST_MAX_SIZE;
+    } else {
+        new_list_p->capacity = capacity;
     }
+    return new_list_p;
+}
 
-    // Create a whole new node.
-    node_t *new_node_p = malloc(sizeof (node_t));
-    if (new_node_p == NULL) {
-        fprintf(stderr, "%s: new_node_p is NULL.\n", __func__);
-        return;
+
+//  ----------------------------------------------------------------------------
+/// \brief  Append data in a new node, see list_append(). The data are owned by
+/// the node, or handed over to the intern table of the list, which frees them
+/// if it already holds equal data.
+/// \attention  The data object must be dynamically allocated since the list's
+/// destroy function uses free() on all data objects.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_add(linkedlist_t *dst, void const * const data)
+{
+    if (dst == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
     }
-    *new_node_p = (node_t) {
+    node_t const payload = {
         .data = data,
+        .entry = NULL,
         .next = NULL
     };
+    return list_append(dst, &payload);
+}
 
-    if (dst->head == NULL) {
-        // NULL head means this list was empty.
-        dst->head = new_node_p;
-    } else {
-        // Walk to the last node.
-        node_t *current_node = (node_t *) dst->head;
-        while (current_node->next != NULL) {
-            current_node = current_node->next;
+
+//  ----------------------------------------------------------------------------
+/// \brief  Unlink the head node and hand its data over to the caller.
+//  ----------------------------------------------------------------------------
+void *linkedlist_pop_front(linkedlist_t * const list)
+{
+    if (list == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+        return NULL;
+    }
+    if (list->head == NULL) {
+        return NULL;
+    }
+
+    void *data = (void *) list->head->data;
+    if (list->head->entry != NULL) {
+        // Shared data stay in the table, the caller gets its own copy.
+        size_t const data_size = list->head->entry->table->data_size;
+        data = malloc(data_size);
+        if (data == NULL) {
+            LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+            return NULL;
         }
-        // current_node is now the last node of dst.
-        current_node->next = new_node_p;
+        memcpy(data, list->head->data, data_size);
+        intern_release(list->head->entry);
+    }
+    free(list_unlink_head(list));
+    return data;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Rotate by relinking the tail to the head and cutting the ring again
+/// before the new head. Only the walk to the new tail, and the update of the
+/// aggregate for the nodes moved to the back, depend on k.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_rotate(linkedlist_t * const list, int const k)
+{
+    if (list == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    if (list->size < 2 || k % list->size == 0) {
+        return LINKEDLIST_OK;
     }
-    dst->size++;
+
+    node_t *new_tail = list_walker(list, (long) k - 1);
+    list->tail->next = list->head;
+    list->head = new_tail->next;
+    new_tail->next = NULL;
+    list->tail = new_tail;
+
+    int const shift = (k % list->size + list->size) % list->size;
+    list_shifted(list, shift, true);
+    return LINKEDLIST_OK;
 }
 
 
@@ -115,21 +386,100 @@ void linkedlist_add(linkedlist_t *dst, void const * const data)
 void linkedlist_destroy(linkedlist_t *list)
 {
     nodes_recursive_destroy(list->head);
+    list_size_set(list, 0);
+    linkedlist_group_set(list, NULL);
+    summary_destroy(list->summary);
+    linkedlist_intern_set(list, NULL);
     free(list);
 }
 
 
 //  ----------------------------------------------------------------------------
-/// \brief  Run the callback function on all nodes' data member.
+/// \brief  Run the callback function on all nodes' data member, shared data
+/// included since the callback reads only.
 //  ----------------------------------------------------------------------------
-void linkedlist_run_for_all(linkedlist_t *list,
-                            void (*callback) (void const * const data))
+linkedlist_status_t linkedlist_run_for_all(
+    linkedlist_t *list,
+    void (*callback)(void const * const data))
 {
-    if (list != NULL) {
-        nodes_run_for_all(list->head, callback);
-    } else {
-        fprintf(stderr, "%s: list is NULL.\n", __func__);
+    if (list == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    nodes_run_for_all(list->head, callback);
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Run the callback on the nodes' data until it returns false.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_fold(linkedlist_t * const list,
+                                    linkedlist_visitor_t const callback,
+                                    void * const context)
+{
+    if (list == NULL || callback == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    nodes_find(list->head, callback, context, false, NULL);
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Find the first node whose data satisfies the predicate.
+//  ----------------------------------------------------------------------------
+void *linkedlist_find_first(linkedlist_t * const list,
+                            linkedlist_visitor_t const predicate,
+                            void * const context,
+                            int * const position)
+{
+    if (list == NULL || predicate == NULL) {
+        if (position != NULL) {
+            *position = -1;
+        }
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+        return NULL;
+    }
+    node_t * const found = nodes_find(list->head, predicate, context, true,
+                                      position);
+    if (found == NULL) {
+        return NULL;
+    }
+    if (!node_unshare(found)) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+        return NULL;
+    }
+    return (void *) found->data;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Look for a node whose data satisfies the predicate.
+//  ----------------------------------------------------------------------------
+bool linkedlist_any(linkedlist_t * const list,
+                    linkedlist_visitor_t const predicate,
+                    void * const context)
+{
+    if (list == NULL || predicate == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+        return false;
     }
+    return nodes_find(list->head, predicate, context, true, NULL) != NULL;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Look for a node whose data does not satisfy the predicate.
+//  ----------------------------------------------------------------------------
+bool linkedlist_all(linkedlist_t * const list,
+                    linkedlist_visitor_t const predicate,
+                    void * const context)
+{
+    if (list == NULL || predicate == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+        return false;
+    }
+    return nodes_find(list->head, predicate, context, false, NULL) == NULL;
 }
 
 
@@ -138,15 +488,131 @@ void linkedlist_run_for_all(linkedlist_t *list,
 /// src. Both nodes and data are copied to new locations, no sharing of memory
 /// between src and dst.
 //  ----------------------------------------------------------------------------
-void linkedlist_copy(linkedlist_t *dst, linkedlist_t *src,
-                     size_t const data_size)
+linkedlist_status_t linkedlist_copy(linkedlist_t *dst, linkedlist_t *src,
+                                    size_t const data_size)
+{
+    if (dst == NULL || src == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    long long const growth = memory_growth(dst, src->size, data_size);
+    if (!budget_allows(dst, growth, growth)) {
+        return LINKEDLIST_OVER_BUDGET;
+    }
+
+    // Do not destroy the dst object, only the genes.
+    list_clear(dst);
+    linkedlist_data_size_set(dst, data_size);
+    if (!nodes_recursive_copy(src->head, data_size, dst->intern,
+                              &dst->head)) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+    }
+    dst->tail = nodes_last(dst->head);
+    list_size_set(dst, src->size);
+    length_limit(dst, list_max_size(dst));
+    list_changed(dst, 0);
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Walk src once. For each of its nodes, write the data into the next
+/// node of every dst, reusing the node and its data when there is one, and
+/// linking a new one otherwise. What is left of each dst is destroyed at the
+/// end.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_copy_many(linkedlist_t * const dsts[],
+                                         int const nb_dsts,
+                                         linkedlist_t * const src,
+                                         size_t const data_size)
 {
-    if (dst->head != NULL) {
-        // Do not destroy the dst object, only the genes.
-        nodes_recursive_destroy(dst->head);
+    if (dsts == NULL || src == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    for (int k = 0; k < nb_dsts; k++) {
+        if (dsts[k] == NULL) {
+            return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+        }
+        assert(dsts[k] != src);
+    }
+    if (nb_dsts <= 0) {
+        return LINKEDLIST_OK;
+    }
+    linkedlist_status_t const allowed = budget_allows_many(dsts, nb_dsts,
+                                                           src->size,
+                                                           data_size);
+    if (allowed != LINKEDLIST_OK) {
+        return allowed;
+    }
+
+    // For each dst, the next node to overwrite and the last node written.
+    node_t **walkers = malloc(2 * nb_dsts * sizeof (node_t *));
+    if (walkers == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+    }
+    node_t ** const lasts = &walkers[nb_dsts];
+    for (int k = 0; k < nb_dsts; k++) {
+        walkers[k] = dsts[k]->head;
+        lasts[k] = NULL;
+        linkedlist_data_size_set(dsts[k], data_size);
+    }
+
+    linkedlist_status_t status = LINKEDLIST_OK;
+    int written = 0;
+    for (node_t *from = src->head;
+         from != NULL && status == LINKEDLIST_OK;
+         from = from->next) {
+        for (int k = 0; k < nb_dsts; k++) {
+            node_t *to = walkers[k];
+            if (to == NULL) {
+                to = malloc(sizeof (node_t));
+                if (to == NULL) {
+                    status = LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+                    break;
+                }
+                *to = (node_t) {
+                    .data = NULL,
+                    .entry = NULL,
+                    .next = NULL
+                };
+                if (lasts[k] == NULL) {
+                    dsts[k]->head = to;
+                } else {
+                    lasts[k]->next = to;
+                }
+            }
+            if (!node_data_set(to, from, data_size, dsts[k]->intern)) {
+                status = LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+                walkers[k] = to;
+                break;
+            }
+            lasts[k] = to;
+            walkers[k] = to->next;
+        }
+        if (status == LINKEDLIST_OK) {
+            written++;
+        }
+    }
+
+    // Cut each dst after its last written node. On error, the dsts before the
+    // failing one got one more data than the others: all are truncated to the
+    // data written to every dst.
+    for (int k = 0; k < nb_dsts; k++) {
+        linkedlist_t * const dst = dsts[k];
+        if (lasts[k] == NULL) {
+            list_clear(dst);
+            continue;
+        }
+        nodes_recursive_destroy(lasts[k]->next);
+        lasts[k]->next = NULL;
+        dst->tail = lasts[k];
+        list_size_set(dst, written + (status == LINKEDLIST_OK ? 0 : 1));
+        length_limit(dst, written);
+        length_limit(dst, list_max_size(dst));
+        list_changed(dst, 0);
     }
-    dst->head = nodes_recursive_copy(src->head, data_size);
-    dst->size = src->size;
+
+    free(walkers);
+    return status;
 }
 
 
@@ -154,23 +620,23 @@ void linkedlist_copy(linkedlist_t *dst, linkedlist_t *src,
 /// \brief  Destroy a possibly non-empty sublist and fill it with a copy of list
 /// from position to its end.
 //  ----------------------------------------------------------------------------
-void linkedlist_sublist_copy(linkedlist_t * const dst,
-                             linkedlist_t * const list,
-                             unsigned int const position,
-                             size_t const data_size)
+linkedlist_status_t linkedlist_sublist_copy(linkedlist_t * const dst,
+                                            linkedlist_t * const list,
+                                            unsigned int const position,
+                                            size_t const data_size)
 {
     if (list == NULL || dst == NULL) {
-        fprintf(stderr, "%s: list or dst is NULL.\n", __func__);
-        return;
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
     }
 
-    if (dst->head != NULL) {
-        linkedlist_destroy(dst);
+    if (list->size == 0) {
+        list_clear(dst);
+        return LINKEDLIST_OK;
     }
 
-    node_t *walker = nodes_walker(list->head, position);
-    dst->head = nodes_recursive_copy(walker, data_size);
-    dst->size = list->size - position;
+    linkedlist_view_t tail_view;
+    linkedlist_view_init(&tail_view, list, position % list->size, list->size);
+    return linkedlist_view_copy(dst, &tail_view, data_size);
 }
 
 
@@ -192,66 +658,242 @@ bool linkedlist_compare(linkedlist_t * const list_a,
 /// \brief  Cross lists by changing the .next pointer of the node before
 /// position. Special case when trying to cross from index 0 is taken care of.
 //  ----------------------------------------------------------------------------
-void linkedlist_cross(linkedlist_t * const list_a, int const pos_a,
-                      linkedlist_t * const list_b, int const pos_b)
+linkedlist_status_t linkedlist_cross(linkedlist_t * const list_a,
+                                     int const pos_a,
+                                     linkedlist_t * const list_b,
+                                     int const pos_b)
 {
     if (list_a == NULL || list_b == NULL) {
-        fprintf(stderr, "%s: one of the input lists is NULL.\n", __func__);
-        return;
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+
+    long const new_size_a = (long) pos_a + list_b->size - pos_b;
+    long const new_size_b = (long) pos_b + list_a->size - pos_a;
+    long long const growth_a = memory_growth(list_a, new_size_a,
+                                             list_a->data_size);
+    long long const growth_b = memory_growth(list_b, new_size_b,
+                                             list_b->data_size);
+    bool const same_group = list_a->group == list_b->group;
+    if (!budget_allows(list_a, growth_a,
+                       growth_a + (same_group ? growth_b : 0))
+        || !budget_allows(list_b, growth_b,
+                          growth_b + (same_group ? growth_a : 0))) {
+        return LINKEDLIST_OVER_BUDGET;
     }
 
-    node_t *walker_a = nodes_walker(list_a->head, pos_a - 1);
-    node_t *walker_b = nodes_walker(list_b->head, pos_b - 1);
+    // The nodes before the crossing points, NULL when crossing from the head.
+    node_t *prev_a = (pos_a > 0) ? list_walker(list_a, pos_a - 1) : NULL;
+    node_t *prev_b = (pos_b > 0) ? list_walker(list_b, pos_b - 1) : NULL;
+
+    node_t *part_a = (prev_a != NULL) ? prev_a->next : list_a->head;
+    node_t *part_b = (prev_b != NULL) ? prev_b->next : list_b->head;
+    snode_t * const summary_a = list_tail_detach(list_a, pos_a);
+    snode_t * const summary_b = list_tail_detach(list_b, pos_b);
+    node_t *old_tail_a = list_a->tail;
+    node_t *old_tail_b = list_b->tail;
 
-    node_t *start_of_new_part_for_list_b = walker_a->next;
+    if (prev_a == NULL) {
+        list_a->head = part_b;
+    } else {
+        prev_a->next = part_b;
+    }
 
-    if (pos_a == 0) {
-        start_of_new_part_for_list_b = list_a->head;
-        list_a->head = walker_b->next;
+    if (prev_b == NULL) {
+        list_b->head = part_a;
     } else {
-        walker_a->next = walker_b->next;
+        prev_b->next = part_a;
+    }
+
+    list_a->tail = (part_b != NULL) ? old_tail_b : prev_a;
+    list_b->tail = (part_a != NULL) ? old_tail_a : prev_b;
+
+    // Update the sizes and truncate if a list grows above its max.
+    list_size_set(list_a, new_size_a);
+    list_size_set(list_b, new_size_b);
+    list_tail_attach(list_a, pos_a, list_b->summary, summary_b);
+    list_tail_attach(list_b, pos_b, list_a->summary, summary_a);
+    length_limit(list_a, list_max_size(list_a));
+    length_limit(list_b, list_max_size(list_b));
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Link the head of src after the tail of dst, and empty src. Only
+/// the max size (or the capacity of a circular dst) costs a walk, to drop the
+/// elements in excess.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_concat(linkedlist_t * const dst,
+                                      linkedlist_t * const src)
+{
+    if (dst == NULL || src == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    assert(dst != src);
+    if (src->head == NULL) {
+        return LINKEDLIST_OK;
+    }
+    // The nodes are accounted for with the data size of their list, which
+    // must not change when they move. An empty dst takes that of src.
+    if (dst->data_size != src->data_size) {
+        if (dst->head != NULL) {
+            return LINKEDLIST_ERROR(LINKEDLIST_ERR_MISMATCH);
+        }
+        linkedlist_data_size_set(dst, src->data_size);
+    }
+
+    long const new_size = (long) dst->size + src->size;
+    long long const growth = memory_growth(dst, new_size, dst->data_size);
+    long long const src_growth = memory_growth(src, 0, src->data_size);
+    bool const same_group = dst->group == src->group;
+    if (!budget_allows(dst, growth, growth + (same_group ? src_growth : 0))) {
+        return LINKEDLIST_OVER_BUDGET;
     }
 
-    if (pos_b == 0) {
-        list_b->head = walker_a->next;
+    int const old_size = dst->size;
+    snode_t * const moved = list_tail_detach(src, 0);
+    list_changed(dst, old_size);
+    if (dst->head == NULL) {
+        dst->head = src->head;
     } else {
-        walker_b->next = start_of_new_part_for_list_b;
+        dst->tail->next = src->head;
     }
+    dst->tail = src->tail;
+    src->head = NULL;
+    src->tail = NULL;
+    list_size_set(src, 0);
+    list_size_set(dst, new_size);
+    list_tail_attach(dst, old_size, src->summary, moved);
 
-    // Update the sizes and truncate if a list grows above max.
-    int old_list_a_size = list_a->size;
-    long new_size_a = (long) pos_a + list_b->size - pos_b;
-    if (new_size_a > LINKEDLIST_MAX_SIZE) {
-        length_limit(list_a, LINKEDLIST_MAX_SIZE);
+    if (dst->capacity != 0) {
+        // Sliding window: keep the newest elements.
+        while (dst->size > (int) dst->capacity) {
+            nodes_recursive_destroy(list_unlink_head(dst));
+        }
     } else {
-        list_a->size = new_size_a;
+        length_limit(dst, LINKEDLIST_MAX_SIZE);
+    }
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Walk to the node before position, and cut the list after it. The
+/// nodes of out are destroyed first, it then takes over the cut off nodes.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_split(linkedlist_t * const list,
+                                     int const position,
+                                     linkedlist_t * const out)
+{
+    if (list == NULL || out == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    assert(list != out);
+
+    int const start = (position < 0) ? 0 : position;
+    long const moved = (start < list->size) ? list->size - start : 0;
+    long long const growth = memory_growth(out, moved, list->data_size);
+    long long const list_growth = memory_growth(list, list->size - moved,
+                                                list->data_size);
+    bool const same_group = list->group == out->group;
+    if (!budget_allows(out, growth,
+                       growth + (same_group ? list_growth : 0))) {
+        return LINKEDLIST_OVER_BUDGET;
+    }
+
+    list_clear(out);
+    linkedlist_data_size_set(out, list->data_size);
+    if (moved == 0) {
+        return LINKEDLIST_OK;
     }
 
-    long new_size_b = (long) pos_b + old_list_a_size - pos_a;
-    if (new_size_b > LINKEDLIST_MAX_SIZE) {
-        length_limit(list_b, LINKEDLIST_MAX_SIZE);
+    snode_t * const moved_summary = list_tail_detach(list, start);
+    out->tail = list->tail;
+    if (start == 0) {
+        out->head = list->head;
+        list->head = NULL;
+        list->tail = NULL;
     } else {
-        list_b->size = new_size_b;
+        node_t *prev = list_walker(list, start - 1);
+        out->head = prev->next;
+        prev->next = NULL;
+        list->tail = prev;
     }
+    list_size_set(list, list->size - moved);
+    list_size_set(out, moved);
+    list_tail_attach(out, 0, list->summary, moved_summary);
+    length_limit(out, list_max_size(out));
+    return LINKEDLIST_OK;
 }
 
 
 //  ----------------------------------------------------------------------------
 /// \brief  Walk to the node at position, and get a pointer to the data at that
-/// position.
+/// position. The position is reduced modulo the size before walking.
 /// \param  list
 /// \param  position
-/// \return Pointer to the data at position in list.
+/// \return Pointer to the data at position in list, NULL if list is empty.
 //  ----------------------------------------------------------------------------
 void *linkedlist_data_handle_get(linkedlist_t * const list,
                                  unsigned int const position)
 {
-    node_t *walker = nodes_walker(list->head, position);
+    node_t *walker = list_walker(list, position);
+    if (walker == NULL) {
+        return NULL;
+    }
+    if (!node_unshare(walker)) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+        return NULL;
+    }
 
     return (void *) walker->data;
 }
 
 
+//  ----------------------------------------------------------------------------
+/// \brief  Walk to the node like linkedlist_data_handle_get(), leaving its data
+/// shared.
+//  ----------------------------------------------------------------------------
+void const *linkedlist_data_get(linkedlist_t * const list,
+                                unsigned int const position)
+{
+    node_t const * const walker = list_walker(list, position);
+    return (walker != NULL) ? walker->data : NULL;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Write over the data of the node with node_data_set(), which copies
+/// shared data on write, and update the aggregate of the position.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_data_set(linkedlist_t * const list,
+                                        unsigned int const position,
+                                        void const * const data,
+                                        size_t const data_size)
+{
+    if (list == NULL || data == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    node_t * const walker = list_walker(list, position);
+    if (walker == NULL) {
+        return LINKEDLIST_OK;
+    }
+
+    node_t const from = {
+        .data = data,
+        .entry = NULL,
+        .next = NULL
+    };
+    if (!node_data_set(walker, &from, data_size, list->intern)) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+    }
+    if (list->summary != NULL) {
+        summary_position_update(list->summary, position % list->size);
+    }
+    return LINKEDLIST_OK;
+}
+
+
 //  ----------------------------------------------------------------------------
 /// \brief  Get the list size from the structs data. Not actually going through
 /// the list to its end.
@@ -261,7 +903,7 @@ void *linkedlist_data_handle_get(linkedlist_t * const list,
 int linkedlist_size_get(linkedlist_t * const list)
 {
     if (list == NULL) {
-        fprintf(stderr, "%s: list is NULL.\n", __func__);
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
         return 0;
     } else {
         return list->size;
@@ -269,143 +911,2429 @@ int linkedlist_size_get(linkedlist_t * const list)
 }
 
 
-//******************************************************************************
-// Internal functions
-//******************************************************************************
 //  ----------------------------------------------------------------------------
-/// \brief  Free the node passed as parameter, and run itself on the next node
-/// in the list.
-/// \param  Pointer to the node to free.
+/// \brief  Walk to the start of the range and remember the node there. Nothing
+/// is allocated, the view lives wherever the caller put it.
 //  ----------------------------------------------------------------------------
-static void nodes_recursive_destroy(node_t *node_p)
+void linkedlist_view_init(linkedlist_view_t * const view,
+                          linkedlist_t * const list,
+                          int const start,
+                          int const end)
 {
-    if (node_p == NULL) {
-        return;
-    } else {
-        node_t *rest_of_nodes = node_p->next;
-        if (node_p->data != NULL) {
-            free((void *) node_p->data);
-        }
-        free(node_p);
-        nodes_recursive_destroy(rest_of_nodes);
+    assert(view);
+    assert(list);
+
+    int view_end = (end > list->size) ? list->size : end;
+    if (view_end < 0) {
+        view_end = 0;
     }
+    int view_start = (start < 0) ? 0 : start;
+    if (view_start > view_end) {
+        view_start = view_end;
+    }
+
+    *view = (linkedlist_view_t) {
+        .list = list,
+        .first = list_walker(list, view_start),
+        .start = view_start,
+        .end = view_end,
+        .generation = list->generation
+    };
 }
 
 
 //  ----------------------------------------------------------------------------
-/// \brief  Run the callback on the data field of the node passed as parameter,
-/// and run itself on the next node in the list.
-/// \param  node_p Pointer to the node that has data to run the callback on.
-/// \param  callback The function to run on the node's data.
+/// \brief  Get the number of elements in the view.
 //  ----------------------------------------------------------------------------
-static void nodes_run_for_all(node_t *node_p,
-                              void (*callback)(void const * const data))
+int linkedlist_view_size_get(linkedlist_view_t const * const view)
 {
-    if (node_p == NULL) {
-        return;
-    } else {
-        if (node_p->data == NULL) {
-            fprintf(stderr, "%s: data pointer is NULL.\n", __func__);
-        }
-        callback(node_p->data);
-        nodes_run_for_all(node_p->next, callback);
-    }
+    view_check(view);
+    return view->end - view->start;
 }
 
 
 //  ----------------------------------------------------------------------------
-/// \brief  Allocate memory for new data (content copied from src) and a new
-/// node. Call itself to copy the next node of src (and populate the current
-/// .next with the returned value).
-/// \param  src Node to copy from.
-/// \param  data_size Data block size.
-/// \return Pointer to the newly created node.
+/// \brief  Run the callback on the data of the nodes in the range only.
 //  ----------------------------------------------------------------------------
-static node_t *nodes_recursive_copy(node_t * const src,
-                                    size_t const data_size)
+linkedlist_status_t linkedlist_view_run_for_all(
+    linkedlist_view_t const * const view,
+    void (*callback)(void const * const data))
 {
-    if (src == NULL) {
-        return NULL;
+    if (view == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
     }
+    view_check(view);
 
-    // Allocate a new data object and copy.
-    void *new_data = malloc(data_size);
-    if (new_data != NULL) {
-        memcpy(new_data, src->data, data_size);
+    node_t const *walker = view->first;
+    for (int i = view->start; i < view->end; i++) {
+        callback(walker->data);
+        walker = walker->next;
     }
-
-    // Create a whole new node.
-    node_t *new_node_p = malloc(sizeof (node_t));
-    *new_node_p = (node_t) {
-        .data = new_data,
-        .next = nodes_recursive_copy(src->next, data_size)
-    };
-
-    return new_node_p;
+    return LINKEDLIST_OK;
 }
 
 
 //  ----------------------------------------------------------------------------
-/// \brief  Compare the data of the current node, quit and return false if they
-/// differ, otherwise keep on compare the next node until reaching the end.
-/// \param  a   First node to compare.
-/// \param  b   Second node to compare.
-/// \param  data_size   The size of the data being pointed to by each node.
-/// \return True if the rest of the lists are equal.
+/// \brief  Compare two views element by element, like linkedlist_compare().
 //  ----------------------------------------------------------------------------
-static bool nodes_recursive_compare(node_t * const a, node_t * const b,
-                                    size_t const data_size)
+bool linkedlist_view_compare(linkedlist_view_t const * const view_a,
+                             linkedlist_view_t const * const view_b,
+                             size_t const data_size)
 {
-    if (a == NULL) {
-        if (b != NULL) {
-            return false;
-        }
-        return true;
-    }
+    view_check(view_a);
+    view_check(view_b);
 
-    if (memcmp(a->data, b->data, data_size) != 0) {
+    int const size = view_a->end - view_a->start;
+    if (size != view_b->end - view_b->start) {
         return false;
-    } else {
-        return nodes_recursive_compare(a->next, b->next, data_size);
     }
+
+    node_t *walker_a = view_a->first;
+    node_t *walker_b = view_b->first;
+    for (int i = 0; i < size; i++) {
+        if (nodes_differ(walker_a, walker_b, data_size)) {
+            return false;
+        }
+        walker_a = walker_a->next;
+        walker_b = walker_b->next;
+    }
+    return true;
 }
 
 
-// ----------------------------------------------------------------------------
-/// \brief Walk pos number of nodes from start. If the tail of a list is
-/// reached, go on from head (wrap around).
-/// \param  start   The first node.
+//  ----------------------------------------------------------------------------
+/// \brief  Walk from the first node of the view, position being relative to
+/// the start of the view and reduced modulo the view size.
+//  ----------------------------------------------------------------------------
+void *linkedlist_view_data_handle_get(linkedlist_view_t const * const view,
+                                      unsigned int const position)
+{
+    view_check(view);
+
+    int const size = view->end - view->start;
+    if (size == 0) {
+        return NULL;
+    }
+
+    node_t *walker = nodes_walker(view->first, position % size);
+    if (!node_unshare(walker)) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+        return NULL;
+    }
+    return (void *) walker->data;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Replace the content of dst by a deep copy of the range. Same
+/// copying rules as linkedlist_copy().
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_view_copy(linkedlist_t * const dst,
+                                         linkedlist_view_t const * const view,
+                                         size_t const data_size)
+{
+    if (dst == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    view_check(view);
+    assert(dst != view->list);
+
+    long long const growth = memory_growth(dst, view->end - view->start,
+                                           data_size);
+    if (!budget_allows(dst, growth, growth)) {
+        return LINKEDLIST_OVER_BUDGET;
+    }
+
+    list_clear(dst);
+    linkedlist_data_size_set(dst, data_size);
+
+    node_t *walker = view->first;
+    for (int i = view->start; i < view->end; i++) {
+        node_t payload = {
+            .data = NULL,
+            .entry = NULL,
+            .next = NULL
+        };
+        if (!node_data_copy(&payload, walker, data_size, dst->intern)) {
+            return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+        }
+        linkedlist_status_t const status = list_append(dst, &payload);
+        if (status != LINKEDLIST_OK) {
+            node_data_release(&payload);
+            return status;
+        }
+        walker = walker->next;
+    }
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Walk both lists in lockstep. Same counting as
+/// linkedlist_distance_many(), without its array of walkers.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_distance(linkedlist_t * const list_a,
+                                        linkedlist_t * const list_b,
+                                        size_t const data_size,
+                                        int * const distance)
+{
+    if (list_a == NULL || list_b == NULL || distance == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+
+    // Positions present in only one of the lists all count as differing.
+    *distance = abs(list_a->size - list_b->size);
+
+    node_t const *walker_a = list_a->head;
+    node_t const *walker_b = list_b->head;
+    while (walker_a != NULL && walker_b != NULL) {
+        if (nodes_differ(walker_a, walker_b, data_size)) {
+            (*distance)++;
+        }
+        walker_a = walker_a->next;
+        walker_b = walker_b->next;
+    }
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Walk ref once, and all lists in lockstep with it, so that each data
+/// of ref is loaded once for all comparisons.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_distance_many(linkedlist_t * const ref,
+                                             linkedlist_t * const lists[],
+                                             int const nb_lists,
+                                             size_t const data_size,
+                                             int distances[])
+{
+    if (ref == NULL || lists == NULL || distances == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    if (nb_lists <= 0) {
+        return LINKEDLIST_OK;
+    }
+
+    node_t **walkers = malloc(nb_lists * sizeof (node_t *));
+    if (walkers == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+    }
+
+    // Positions present in only one of the lists all count as differing.
+    for (int j = 0; j < nb_lists; j++) {
+        if (lists[j] == NULL) {
+            free(walkers);
+            return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+        }
+        walkers[j] = lists[j]->head;
+        distances[j] = abs(ref->size - lists[j]->size);
+    }
+
+    for (node_t *walker = ref->head; walker != NULL; walker = walker->next) {
+        for (int j = 0; j < nb_lists; j++) {
+            if (walkers[j] == NULL) {
+                continue;
+            }
+            if (nodes_differ(walker, walkers[j], data_size)) {
+                distances[j]++;
+            }
+            walkers[j] = walkers[j]->next;
+        }
+    }
+
+    free(walkers);
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Fill the upper triangle with one-against-many rows, and mirror it.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_distance_all_pairs(linkedlist_t * const lists[],
+                                                  int const nb_lists,
+                                                  size_t const data_size,
+                                                  int distances[])
+{
+    if (lists == NULL || distances == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+
+    for (int i = 0; i < nb_lists; i++) {
+        int * const row = &distances[i * nb_lists];
+        row[i] = 0;
+        if (i + 1 == nb_lists) {
+            break;
+        }
+
+        linkedlist_status_t const status =
+            linkedlist_distance_many(lists[i], &lists[i + 1],
+                                     nb_lists - i - 1, data_size, &row[i + 1]);
+        if (status != LINKEDLIST_OK) {
+            return status;
+        }
+        for (int j = i + 1; j < nb_lists; j++) {
+            distances[j * nb_lists + i] = row[j];
+        }
+    }
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Account for the data of list with the new size.
+//  ----------------------------------------------------------------------------
+void linkedlist_data_size_set(linkedlist_t * const list,
+                              size_t const data_size)
+{
+    if (list == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+        return;
+    }
+    long long const delta = (long long) list->size
+        * ((long long) data_charge(list, data_size)
+           - (long long) data_charge(list, list->data_size));
+    memory_account(list, delta);
+    list->data_size = data_size;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Computed from the size, no walk through the list.
+//  ----------------------------------------------------------------------------
+size_t linkedlist_memory_get(linkedlist_t * const list)
+{
+    if (list == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+        return 0;
+    }
+    return list_memory(list->size, data_charge(list, list->data_size));
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Read the global counter.
+//  ----------------------------------------------------------------------------
+size_t linkedlist_memory_total_get(void)
+{
+    return __atomic_load_n(&memory_total, __ATOMIC_RELAXED);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Set the budget, without checking the current memory against it.
+//  ----------------------------------------------------------------------------
+void linkedlist_budget_set(linkedlist_t * const list, size_t const budget)
+{
+    if (list == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+        return;
+    }
+    list->budget = budget;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Create an empty group.
+//  ----------------------------------------------------------------------------
+linkedlist_group_t *linkedlist_group_create(size_t const budget)
+{
+    linkedlist_group_t *new_group_p = malloc(sizeof (linkedlist_group_t));
+    if (new_group_p == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+        return NULL;
+    }
+    *new_group_p = (linkedlist_group_t) {
+        .budget = budget,
+        .memory = 0,
+        .nb_lists = 0
+    };
+    return new_group_p;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Free the group, which must have no lists left.
+//  ----------------------------------------------------------------------------
+void linkedlist_group_destroy(linkedlist_group_t *group)
+{
+    if (group == NULL) {
+        return;
+    }
+    assert(__atomic_load_n(&group->nb_lists, __ATOMIC_RELAXED) == 0);
+    free(group);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Move the memory of list from its old group to the new one.
+//  ----------------------------------------------------------------------------
+void linkedlist_group_set(linkedlist_t * const list,
+                          linkedlist_group_t * const group)
+{
+    if (list == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+        return;
+    }
+
+    size_t const memory = linkedlist_memory_get(list);
+    if (list->group != NULL) {
+        __atomic_sub_fetch(&list->group->memory, memory, __ATOMIC_RELAXED);
+        __atomic_sub_fetch(&list->group->nb_lists, 1, __ATOMIC_RELAXED);
+    }
+    list->group = group;
+    if (group != NULL) {
+        __atomic_add_fetch(&group->memory, memory, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&group->nb_lists, 1, __ATOMIC_RELAXED);
+    }
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Read the group counter.
+//  ----------------------------------------------------------------------------
+size_t linkedlist_group_memory_get(linkedlist_group_t * const group)
+{
+    if (group == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+        return 0;
+    }
+    return __atomic_load_n(&group->memory, __ATOMIC_RELAXED);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Replace the summary of list by an empty one for aggregate. The
+/// tree is built on the first query.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_aggregate_set(
+    linkedlist_t * const list,
+    linkedlist_aggregate_t const * const aggregate)
+{
+    if (list == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+
+    summary_destroy(list->summary);
+    list->summary = NULL;
+    if (aggregate == NULL) {
+        return LINKEDLIST_OK;
+    }
+    assert(aggregate->map != NULL && aggregate->combine != NULL);
+    assert(aggregate->identity != NULL && aggregate->value_size > 0);
+
+    summary_t *summary = malloc(sizeof (summary_t));
+    unsigned char *values = malloc(2 * aggregate->value_size);
+    if (summary == NULL || values == NULL) {
+        free(summary);
+        free(values);
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+    }
+    memcpy(values, aggregate->identity, aggregate->value_size);
+    *summary = (summary_t) {
+        .aggregate = *aggregate,
+        .root = NULL,
+        .values = values
+    };
+    summary->aggregate.identity = values;
+    list->summary = summary;
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Bring the treap up to date, then combine the O(log n) subtrees and
+/// nodes covering [start, end), from left to right.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_aggregate_get(linkedlist_t * const list,
+                                             int const start,
+                                             int const end,
+                                             void * const result)
+{
+    if (list == NULL || result == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    summary_t * const summary = list->summary;
+    if (summary == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_AGGREGATE);
+    }
+    linkedlist_status_t const status = summary_update(list);
+    if (status != LINKEDLIST_OK) {
+        return status;
+    }
+
+    memcpy(result, summary->aggregate.identity, summary->aggregate.value_size);
+    snode_fold(summary, summary->root, start, end, result);
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Map the data again and recompute the aggregates of the subtrees
+/// holding it. If the position is not up to date anyway, the next query takes
+/// care of it.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_aggregate_update(linkedlist_t * const list,
+                                                int const position)
+{
+    if (list == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    summary_t * const summary = list->summary;
+    if (summary == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_AGGREGATE);
+    }
+    summary_position_update(summary, position);
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Allocate an empty table, with a few buckets to start with.
+//  ----------------------------------------------------------------------------
+linkedlist_intern_t *linkedlist_intern_create(size_t const data_size)
+{
+    size_t const nb_buckets = 64;
+    linkedlist_intern_t *table = malloc(sizeof (linkedlist_intern_t));
+    intern_entry_t **buckets = calloc(nb_buckets, sizeof (intern_entry_t *));
+    if (table == NULL || buckets == NULL) {
+        free(table);
+        free(buckets);
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+        return NULL;
+    }
+    *table = (linkedlist_intern_t) {
+        .data_size = data_size,
+        .nb_buckets = nb_buckets,
+        .nb_entries = 0,
+        .buckets = buckets,
+        .nb_lists = 0,
+        .lock = false
+    };
+    return table;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Free the table, which must have no lists and no data left.
+//  ----------------------------------------------------------------------------
+void linkedlist_intern_destroy(linkedlist_intern_t *table)
+{
+    if (table == NULL) {
+        return;
+    }
+    assert(table->nb_lists == 0);
+    assert(table->nb_entries == 0);
+    free(table->buckets);
+    free(table);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Switch the table of list, and move the data already in list to
+/// it: owned data are handed over, data shared in another table are copied.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_intern_set(linkedlist_t * const list,
+                                          linkedlist_intern_t * const table)
+{
+    if (list == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    // Data are hashed and compared on the data size of the table.
+    if (table != NULL && list->data_size != 0
+        && list->data_size != table->data_size) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_MISMATCH);
+    }
+
+    if (list->intern != NULL) {
+        __atomic_sub_fetch(&list->intern->nb_lists, 1, __ATOMIC_RELAXED);
+    }
+    // The data are charged to the table instead of list, or back.
+    long long const memory = linkedlist_memory_get(list);
+    list->intern = table;
+    memory_account(list, (long long) linkedlist_memory_get(list) - memory);
+    if (table == NULL) {
+        return LINKEDLIST_OK;
+    }
+    __atomic_add_fetch(&table->nb_lists, 1, __ATOMIC_RELAXED);
+    linkedlist_data_size_set(list, table->data_size);
+
+    for (node_t *walker = list->head; walker != NULL; walker = walker->next) {
+        if (walker->data == NULL) {
+            // Nothing to share.
+            continue;
+        }
+        if (walker->entry == NULL) {
+            intern_entry_t * const entry = intern_get(table, walker->data,
+                                                      (void *) walker->data);
+            if (entry == NULL) {
+                return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+            }
+            walker->entry = entry;
+            walker->data = entry->data;
+        } else if (walker->entry->table != table) {
+            node_t shared = {
+                .data = NULL,
+                .entry = NULL,
+                .next = NULL
+            };
+            if (!node_data_copy(&shared, walker, table->data_size, table)) {
+                return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+            }
+            node_data_release(walker);
+            walker->entry = shared.entry;
+            walker->data = shared.data;
+        }
+    }
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the number of entries of the table.
+//  ----------------------------------------------------------------------------
+size_t linkedlist_intern_size_get(linkedlist_intern_t const * const table)
+{
+    if (table == NULL) {
+        return 0;
+    }
+    return __atomic_load_n(&table->nb_entries, __ATOMIC_RELAXED);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Allocate an empty delta, its arrays grow when filled.
+//  ----------------------------------------------------------------------------
+linkedlist_delta_t *linkedlist_delta_create(void)
+{
+    linkedlist_delta_t *delta = malloc(sizeof (linkedlist_delta_t));
+    if (delta == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+        return NULL;
+    }
+    *delta = (linkedlist_delta_t) {
+        .data_size = 0,
+        .base_size = 0,
+        .size = 0,
+        .nb_ranges = 0,
+        .max_ranges = 0,
+        .ranges = NULL,
+        .payloads_used = 0,
+        .payloads_max = 0,
+        .payloads = NULL
+    };
+    return delta;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Free the delta and its arrays.
+//  ----------------------------------------------------------------------------
+void linkedlist_delta_destroy(linkedlist_delta_t *delta)
+{
+    if (delta == NULL) {
+        return;
+    }
+    free(delta->ranges);
+    free(delta->payloads);
+    free(delta);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Walk both lists in lockstep, and copy into the delta the data of to
+/// at each position where they differ or where from has ended. Consecutive
+/// positions make one range.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_diff(linkedlist_delta_t * const delta,
+                                    linkedlist_t * const from,
+                                    linkedlist_t * const to,
+                                    size_t const data_size)
+{
+    if (delta == NULL || from == NULL || to == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+
+    delta_reset(delta, data_size, from->size, to->size);
+    node_t *walker_from = from->head;
+    int position = 0;
+    for (node_t *walker_to = to->head;
+         walker_to != NULL;
+         walker_to = walker_to->next) {
+        if (walker_from == NULL
+            || nodes_differ(walker_from, walker_to, data_size)) {
+            unsigned char * const payload = delta_payload_reserve(delta,
+                                                                  position);
+            if (payload == NULL) {
+                delta_reset(delta, data_size, 0, 0);
+                return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+            }
+            memcpy(payload, walker_to->data, data_size);
+        }
+        if (walker_from != NULL) {
+            walker_from = walker_from->next;
+        }
+        position++;
+    }
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Truncate list, then walk it once over the ranges, writing over the
+/// data of existing positions and appending the others.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_patch(linkedlist_t * const list,
+                                     linkedlist_delta_t const * const delta)
+{
+    if (list == NULL || delta == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+    if (list->size != delta->base_size) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_MISMATCH);
+    }
+    if (list->data_size != 0 && list->data_size != delta->data_size) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_MISMATCH);
+    }
+    if (list->intern != NULL && list->intern->data_size != delta->data_size) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_MISMATCH);
+    }
+    // Appending past the capacity would evict the head, which patching
+    // cannot account for.
+    if (delta->size > list_max_size(list)) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_MISMATCH);
+    }
+    long long const growth = memory_growth(list, delta->size,
+                                           delta->data_size);
+    if (!budget_allows(list, growth, growth)) {
+        return LINKEDLIST_OVER_BUDGET;
+    }
+
+    linkedlist_data_size_set(list, delta->data_size);
+    if (delta->size < list->size) {
+        length_limit(list, delta->size);
+        list_changed(list, delta->size);
+    }
+    if (delta->nb_ranges == 0) {
+        return LINKEDLIST_OK;
+    }
+    list_changed(list, delta->ranges[0].start);
+
+    node_t *walker = list->head;
+    int position = 0;
+    for (int r = 0; r < delta->nb_ranges; r++) {
+        delta_range_t const * const range = &delta->ranges[r];
+        for (int i = 0; i < range->count; i++) {
+            node_t const from = {
+                .data = &delta->payloads[range->offset
+                                         + i * delta->data_size],
+                .entry = NULL,
+                .next = NULL
+            };
+            if (range->start + i < list->size) {
+                while (position < range->start + i) {
+                    walker = walker->next;
+                    position++;
+                }
+                if (!node_data_set(walker, &from, delta->data_size,
+                                   list->intern)) {
+                    return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+                }
+                continue;
+            }
+
+            node_t payload = {
+                .data = NULL,
+                .entry = NULL,
+                .next = NULL
+            };
+            if (!node_data_copy(&payload, &from, delta->data_size,
+                                list->intern)) {
+                return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+            }
+            linkedlist_status_t const status = list_append(list, &payload);
+            if (status != LINKEDLIST_OK) {
+                node_data_release(&payload);
+                return status;
+            }
+        }
+    }
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the number of data held by the delta.
+//  ----------------------------------------------------------------------------
+int linkedlist_delta_size_get(linkedlist_delta_t const * const delta)
+{
+    if (delta == NULL || delta->data_size == 0) {
+        return 0;
+    }
+    return (int) (delta->payloads_used / delta->data_size);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Write the header, then each range followed by its data. Integers
+/// are 32 bits little endian.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_delta_write(
+    linkedlist_delta_t const * const delta,
+    FILE * const stream)
+{
+    if (delta == NULL || stream == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+
+    bool ok = fwrite(delta_magic, 1, sizeof delta_magic, stream)
+              == sizeof delta_magic;
+    ok = ok && stream_u32_write(stream, delta->data_size);
+    ok = ok && stream_u32_write(stream, delta->base_size);
+    ok = ok && stream_u32_write(stream, delta->size);
+    ok = ok && stream_u32_write(stream, delta->nb_ranges);
+    for (int r = 0; ok && r < delta->nb_ranges; r++) {
+        delta_range_t const * const range = &delta->ranges[r];
+        size_t const bytes = range->count * delta->data_size;
+        ok = stream_u32_write(stream, range->start)
+             && stream_u32_write(stream, range->count)
+             && fwrite(&delta->payloads[range->offset], 1, bytes, stream)
+                == bytes;
+    }
+    if (!ok) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_IO);
+    }
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Read what linkedlist_delta_write() wrote, range by range, checking
+/// each against the header before reading its data.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_delta_read(linkedlist_delta_t * const delta,
+                                          FILE * const stream)
+{
+    if (delta == NULL || stream == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+
+    unsigned char magic[sizeof delta_magic];
+    unsigned long data_size;
+    unsigned long base_size;
+    unsigned long size;
+    unsigned long nb_ranges;
+    bool ok = fread(magic, 1, sizeof magic, stream) == sizeof magic
+              && memcmp(magic, delta_magic, sizeof magic) == 0
+              && stream_u32_read(stream, &data_size)
+              && stream_u32_read(stream, &base_size)
+              && stream_u32_read(stream, &size)
+              && stream_u32_read(stream, &nb_ranges)
+              && data_size > 0
+              && data_size <= delta_data_size_max
+              && base_size <= LINKEDLIST_MAX_SIZE
+              && size <= LINKEDLIST_MAX_SIZE;
+    if (!ok) {
+        delta_reset(delta, 0, 0, 0);
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_IO);
+    }
+
+    delta_reset(delta, data_size, base_size, size);
+    for (unsigned long r = 0; r < nb_ranges; r++) {
+        unsigned long start;
+        unsigned long count;
+        ok = stream_u32_read(stream, &start)
+             && stream_u32_read(stream, &count)
+             && delta_range_check(delta, start, count)
+             && count <= (delta_payloads_max - delta->payloads_used)
+                         / data_size;
+        for (unsigned long i = 0; ok && i < count; i++) {
+            unsigned char * const payload = delta_payload_reserve(delta,
+                                                                  start + i);
+            if (payload == NULL) {
+                delta_reset(delta, 0, 0, 0);
+                return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+            }
+            ok = fread(payload, 1, data_size, stream) == data_size;
+        }
+        if (!ok) {
+            break;
+        }
+    }
+    // All appended positions must have their data. Adjacent ranges were
+    // merged, so they are all in the last one.
+    if (ok && delta->size > delta->base_size) {
+        delta_range_t const * const last = (delta->nb_ranges > 0)
+            ? &delta->ranges[delta->nb_ranges - 1] : NULL;
+        ok = last != NULL && last->start <= delta->base_size
+             && last->start + last->count == delta->size;
+    }
+    if (!ok) {
+        delta_reset(delta, 0, 0, 0);
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_IO);
+    }
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Read the thread local last error.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_last_error_get(void)
+{
+    return last_error;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Reset the thread local last error.
+//  ----------------------------------------------------------------------------
+void linkedlist_last_error_clear(void)
+{
+    last_error = LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Install the log hook.
+//  ----------------------------------------------------------------------------
+void linkedlist_log_hook_set(linkedlist_log_hook_t const hook)
+{
+    log_hook = hook;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Print the error on stderr.
+//  ----------------------------------------------------------------------------
+void linkedlist_log_stderr(linkedlist_status_t status, char const *func)
+{
+    fprintf(stderr, "%s: %s.\n", func, linkedlist_status_str(status));
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Map status codes to fixed strings.
+//  ----------------------------------------------------------------------------
+char const *linkedlist_status_str(linkedlist_status_t const status)
+{
+    switch (status) {
+    case LINKEDLIST_OK:
+        return "no error";
+    case LINKEDLIST_FULL:
+        return "list is full";
+    case LINKEDLIST_OVER_BUDGET:
+        return "memory budget exceeded";
+    case LINKEDLIST_ERR_NULL:
+        return "NULL parameter";
+    case LINKEDLIST_ERR_NO_MEMORY:
+        return "out of memory";
+    case LINKEDLIST_ERR_NO_AGGREGATE:
+        return "no aggregate set on the list";
+    case LINKEDLIST_ERR_MISMATCH:
+        return "lists or delta do not match";
+    case LINKEDLIST_ERR_IO:
+        return "stream error or malformed data";
+    }
+    return "unknown status";
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Save the error for linkedlist_last_error_get(), and hand it to the
+/// log hook. Only called on error paths, never per node.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_error_report(linkedlist_status_t const status,
+                                            char const * const func)
+{
+    last_error = status;
+    if (log_hook != NULL) {
+        log_hook(status, func);
+    }
+    return status;
+}
+
+
+//******************************************************************************
+// Internal functions
+//******************************************************************************
+//  ----------------------------------------------------------------------------
+/// \brief  Free the node passed as parameter, and run itself on the next node
+/// in the list.
+/// \param  Pointer to the node to free.
+//  ----------------------------------------------------------------------------
+static void nodes_recursive_destroy(node_t *node_p)
+{
+    if (node_p == NULL) {
+        return;
+    } else {
+        node_t *rest_of_nodes = node_p->next;
+        node_data_release(node_p);
+        free(node_p);
+        nodes_recursive_destroy(rest_of_nodes);
+    }
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Run the callback on the data field of the node passed as parameter,
+/// and of all the following nodes in the list. The data pointers are passed as
+/// they are, NULL included: checking them is left to the callback.
+/// Shared data are passed shared, the callback reading them only.
+/// \param  node_p Pointer to the node that has data to run the callback on.
+/// \param  callback The function to run on the node's data.
+//  ----------------------------------------------------------------------------
+static void nodes_run_for_all(node_t *node_p,
+                              void (*callback)(void const * const data))
+{
+    for (node_t const *walker = node_p; walker != NULL;
+         walker = walker->next) {
+        callback(walker->data);
+    }
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Run the visitor on the data of the node passed as parameter and of
+/// the following nodes, until it returns until.
+/// \param  node_p  First node to visit.
+/// \param  visitor Function to run on the nodes' data.
+/// \param  context Passed to visitor.
+/// \param  until   The return value of visitor that stops the traversal.
+/// \param  position    Where to write the position of the node returned from
+/// node_p, or -1 if none. May be NULL.
+/// \return The node on which visitor returned until, or NULL if none.
+//  ----------------------------------------------------------------------------
+static node_t *nodes_find(node_t *node_p,
+                          linkedlist_visitor_t const visitor,
+                          void * const context,
+                          bool const until,
+                          int * const position)
+{
+    int i = 0;
+    for (node_t *walker = node_p; walker != NULL; walker = walker->next) {
+        if (visitor(walker->data, context) == until) {
+            if (position != NULL) {
+                *position = i;
+            }
+            return walker;
+        }
+        i++;
+    }
+    if (position != NULL) {
+        *position = -1;
+    }
+    return NULL;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Allocate memory for new data (content copied from src) and a new
+/// node. Call itself to copy the next node of src (and populate the current
+/// .next with the copy). With a table, the data are shared instead, see
+/// node_data_copy().
+/// \param  src Node to copy from.
+/// \param  data_size Data block size.
+/// \param  table Intern table of the copy, NULL for owned data.
+/// \param  copy Where to write the pointer to the first new node, NULL if src
+/// is NULL or out of memory.
+/// \return False if out of memory, nothing is left allocated.
+//  ----------------------------------------------------------------------------
+static bool nodes_recursive_copy(node_t * const src,
+                                 size_t const data_size,
+                                 linkedlist_intern_t * const table,
+                                 node_t ** const copy)
+{
+    *copy = NULL;
+    if (src == NULL) {
+        return true;
+    }
+
+    // Create a whole new node, with a copy of the data.
+    node_t *new_node_p = malloc(sizeof (node_t));
+    if (new_node_p == NULL) {
+        return false;
+    }
+    *new_node_p = (node_t) {
+        .data = NULL,
+        .entry = NULL,
+        .next = NULL
+    };
+    if (!node_data_copy(new_node_p, src, data_size, table)
+        || !nodes_recursive_copy(src->next, data_size, table,
+                                 &new_node_p->next)) {
+        nodes_recursive_destroy(new_node_p);
+        return false;
+    }
+
+    *copy = new_node_p;
+    return true;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Compare the data of the current node, quit and return false if they
+/// differ, otherwise keep on compare the next node until reaching the end.
+/// \param  a   First node to compare.
+/// \param  b   Second node to compare.
+/// \param  data_size   The size of the data being pointed to by each node.
+/// \return True if the rest of the lists are equal.
+//  ----------------------------------------------------------------------------
+static bool nodes_recursive_compare(node_t * const a, node_t * const b,
+                                    size_t const data_size)
+{
+    if (a == NULL) {
+        if (b != NULL) {
+            return false;
+        }
+        return true;
+    }
+
+    if (nodes_differ(a, b, data_size)) {
+        return false;
+    } else {
+        return nodes_recursive_compare(a->next, b->next, data_size);
+    }
+}
+
+
+// ----------------------------------------------------------------------------
+/// \brief Walk pos number of nodes from start. If the tail of a list is
+/// reached, go on from head (wrap around).
+/// \param  start   The first node.
 /// \param  pos     Number of steps to take. May be negative.
 /// \return Pointer to the target node.
 //  ----------------------------------------------------------------------------
-static node_t *nodes_walker(node_t * const start, int const pos)
+static node_t *nodes_walker(node_t * const start, int const pos)
+{
+    node_t *walker = start;
+    for (int i = 0; i < pos; i++) {
+        if (walker->next != NULL) {
+            walker = walker->next;
+        } else {
+            // wrap around.
+            walker = start;
+        }
+    }
+    return walker;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Walk to the last node of a chain of nodes.
+/// \param  start   The first node, may be NULL.
+/// \return Pointer to the last node, NULL if start was NULL.
+//  ----------------------------------------------------------------------------
+static node_t *nodes_last(node_t * const start)
+{
+    node_t *walker = start;
+    while (walker != NULL && walker->next != NULL) {
+        walker = walker->next;
+    }
+    return walker;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the node at pos in list, treating the list as circular. pos is
+/// reduced modulo the size first, so that any position costs less than one
+/// lap. The tail is reached without walking.
+/// \param  list    The list to walk.
+/// \param  pos     Position of the target node. May be negative.
+/// \return Pointer to the target node, NULL if the list is empty.
+//  ----------------------------------------------------------------------------
+static node_t *list_walker(linkedlist_t const * const list, long const pos)
+{
+    if (list->size == 0) {
+        return NULL;
+    }
+
+    long steps = pos % list->size;
+    if (steps < 0) {
+        steps += list->size;
+    }
+    if (steps == list->size - 1) {
+        return list->tail;
+    }
+    return nodes_walker(list->head, steps);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Truncate the list after position limit, and record the change.
+/// \param  list    The list to truncate.
+/// \param  limit   The max size of the resulting list.
+//  ----------------------------------------------------------------------------
+static void length_limit(linkedlist_t * const list, int const limit)
+{
+    if (list->size <= limit) {
+        return;
+    }
+    list_changed(list, limit);
+    if (limit == 0) {
+        nodes_recursive_destroy(list->head);
+        list->head = NULL;
+        list->tail = NULL;
+        list_size_set(list, 0);
+        return;
+    }
+
+    node_t *walker = nodes_walker(list->head, limit - 1);
+    nodes_recursive_destroy(walker->next);
+    walker->next = NULL;
+    list->tail = walker;
+    list_size_set(list, limit);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the number of elements that list may hold.
+/// \param  list    The list.
+/// \return Its capacity if circular, LINKEDLIST_MAX_SIZE otherwise.
+//  ----------------------------------------------------------------------------
+static int list_max_size(linkedlist_t const * const list)
+{
+    return (list->capacity != 0) ? (int) list->capacity
+                                 : (int) LINKEDLIST_MAX_SIZE;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Check if two data differ. Identical pointers are equal without
+/// reading them. Otherwise the differences are accumulated over vectors of 32
+/// (AVX2) and/or 16 (SSE2) bytes, whichever the compiler targets, and tested
+/// once: most compared data are equal, so early exits would not pay for their
+/// branches. The remaining bytes go to memcmp(). Define LINKEDLIST_NO_SIMD to
+/// use memcmp() only.
+/// \param  a   First data.
+/// \param  b   Second data.
+/// \param  data_size   The size of the data.
+/// \return True if at least one byte differs.
+//  ----------------------------------------------------------------------------
+static bool payload_differs(void const * const a, void const * const b,
+                            size_t const data_size)
+{
+    if (a == b) {
+        return false;
+    }
+
+    unsigned char const * const bytes_a = a;
+    unsigned char const * const bytes_b = b;
+    size_t i = 0;
+
+#if !defined(LINKEDLIST_NO_SIMD) && defined(__AVX2__)
+    if (data_size >= 32) {
+        __m256i diff = _mm256_setzero_si256();
+        for (; i + 32 <= data_size; i += 32) {
+            __m256i const va =
+                _mm256_loadu_si256((__m256i const *) &bytes_a[i]);
+            __m256i const vb =
+                _mm256_loadu_si256((__m256i const *) &bytes_b[i]);
+            diff = _mm256_or_si256(diff, _mm256_xor_si256(va, vb));
+        }
+        if (!_mm256_testz_si256(diff, diff)) {
+            return true;
+        }
+    }
+#endif
+#if !defined(LINKEDLIST_NO_SIMD) && defined(__SSE2__)
+    if (data_size - i >= 16) {
+        __m128i diff = _mm_setzero_si128();
+        for (; i + 16 <= data_size; i += 16) {
+            __m128i const va = _mm_loadu_si128((__m128i const *) &bytes_a[i]);
+            __m128i const vb = _mm_loadu_si128((__m128i const *) &bytes_b[i]);
+            diff = _mm_or_si128(diff, _mm_xor_si128(va, vb));
+        }
+        __m128i const zero = _mm_setzero_si128();
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(diff, zero)) != 0xFFFF) {
+            return true;
+        }
+    }
+#endif
+
+    return memcmp(&bytes_a[i], &bytes_b[i], data_size - i) != 0;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Destroy all nodes of the list, keeping the list object itself.
+/// \param  list    The list to empty.
+//  ----------------------------------------------------------------------------
+static void list_clear(linkedlist_t * const list)
+{
+    nodes_recursive_destroy(list->head);
+    list->head = NULL;
+    list->tail = NULL;
+    list_size_set(list, 0);
+    list_changed(list, 0);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Memory used by the nodes and data of a list of size elements.
+/// \param  size    Number of elements.
+/// \param  data_size   Bytes charged for one data, see data_charge().
+/// \return Bytes.
+//  ----------------------------------------------------------------------------
+static size_t list_memory(long const size, size_t const data_size)
+{
+    return (size_t) size * (sizeof (node_t) + data_size);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Bytes charged to list for each of its data. Interned data are
+/// charged once per table entry instead, by intern_insert(), so that a list
+/// is charged for its nodes only while it interns.
+/// \param  list    The list.
+/// \param  data_size   Size of one data of list.
+/// \return Bytes.
+//  ----------------------------------------------------------------------------
+static size_t data_charge(linkedlist_t const * const list,
+                          size_t const data_size)
+{
+    return (list->intern != NULL) ? 0 : data_size;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Add delta bytes to the global memory count, and to the group of
+/// list if any. Both are updated atomically, since the lists of a group may be
+/// used by different threads.
+/// \param  list    The list whose memory changed, NULL for memory of no list.
+/// \param  delta   Change in bytes, negative when memory is released.
+//  ----------------------------------------------------------------------------
+static void memory_account(linkedlist_t * const list, long long const delta)
+{
+    if (delta == 0) {
+        return;
+    }
+    __atomic_add_fetch(&memory_total, (size_t) delta, __ATOMIC_RELAXED);
+    if (list != NULL && list->group != NULL) {
+        __atomic_add_fetch(&list->group->memory, (size_t) delta,
+                           __ATOMIC_RELAXED);
+    }
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Set the size of list, and account for the memory it changes. All
+/// size changes go through here.
+/// \param  list    The list to update.
+/// \param  size    The new size.
+//  ----------------------------------------------------------------------------
+static void list_size_set(linkedlist_t * const list, long const size)
+{
+    long long const per_node = sizeof (node_t)
+        + data_charge(list, list->data_size);
+    memory_account(list, (size - list->size) * per_node);
+    list->size = size;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Bytes that list would gain by changing to new_size elements of
+/// new_data_size bytes. The elements above the max size of list are not
+/// counted, since they are truncated or evicted.
+/// \param  list    The list that would change.
+/// \param  new_size    Its new size.
+/// \param  new_data_size   Its new data size.
+/// \return The growth in bytes, negative if list would shrink.
+//  ----------------------------------------------------------------------------
+static long long memory_growth(linkedlist_t const * const list,
+                               long const new_size,
+                               size_t const new_data_size)
+{
+    long const max_size = list_max_size(list);
+    long const size = (new_size > max_size) ? max_size : new_size;
+    return (long long) list_memory(size, data_charge(list, new_data_size))
+        - (long long) list_memory(list->size,
+                                  data_charge(list, list->data_size));
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Check that list may grow by growth bytes with respect to its own
+/// budget, and its group by group_growth bytes with respect to the group's.
+/// Shrinking is always allowed, even when over budget.
+/// \param  list    The list that would change.
+/// \param  growth  Bytes that list would gain.
+/// \param  group_growth    Bytes that the group of list would gain, which
+/// includes growth and that of other lists of the group changing at the same
+/// time.
+/// \return True if the change fits.
+//  ----------------------------------------------------------------------------
+static bool budget_allows(linkedlist_t const * const list,
+                          long long const growth,
+                          long long const group_growth)
+{
+    if (growth > 0 && list->budget != 0) {
+        size_t const memory = list_memory(list->size,
+                                          data_charge(list, list->data_size));
+        if (memory + (size_t) growth > list->budget) {
+            return false;
+        }
+    }
+
+    linkedlist_group_t const * const group = list->group;
+    if (group_growth > 0 && group != NULL && group->budget != 0) {
+        size_t const memory = __atomic_load_n(&group->memory,
+                                              __ATOMIC_RELAXED);
+        if (memory + (size_t) group_growth > group->budget) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Check that lists may all change to new_size elements of
+/// new_data_size bytes at the same time, like budget_allows() for each. The
+/// growth of each list is computed once; sorted by group, they are summed to
+/// check each group once, in O(n log n) for n lists.
+/// \param  lists   The lists that would change, not NULL.
+/// \param  nb_lists    Number of lists, more than 0.
+/// \param  new_size    Their new size.
+/// \param  new_data_size   Their new data size.
+/// \return LINKEDLIST_OK if the change fits, LINKEDLIST_OVER_BUDGET if not, or
+/// an error status.
+//  ----------------------------------------------------------------------------
+static linkedlist_status_t budget_allows_many(linkedlist_t * const lists[],
+                                              int const nb_lists,
+                                              long const new_size,
+                                              size_t const new_data_size)
+{
+    list_growth_t * const growths = malloc(nb_lists * sizeof (list_growth_t));
+    if (growths == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+    }
+    for (int k = 0; k < nb_lists; k++) {
+        growths[k] = (list_growth_t) {
+            .list = lists[k],
+            .growth = memory_growth(lists[k], new_size, new_data_size)
+        };
+    }
+    qsort(growths, nb_lists, sizeof (list_growth_t), list_growth_compare);
+
+    bool allowed = true;
+    long long group_growth = 0;
+    for (int k = 0; allowed && k < nb_lists; k++) {
+        linkedlist_t const * const list = growths[k].list;
+        group_growth += growths[k].growth;
+        allowed = budget_allows(list, growths[k].growth, 0);
+        // The group is checked after its last list.
+        if (k + 1 == nb_lists || growths[k + 1].list->group != list->group) {
+            allowed = allowed && budget_allows(list, 0, group_growth);
+            group_growth = 0;
+        }
+    }
+    free(growths);
+    return allowed ? LINKEDLIST_OK : LINKEDLIST_OVER_BUDGET;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Order list_growth_t by the group of their list, for qsort().
+//  ----------------------------------------------------------------------------
+static int list_growth_compare(void const * const a, void const * const b)
+{
+    uintptr_t const group_a = (uintptr_t) ((list_growth_t const *) a)
+                                  ->list->group;
+    uintptr_t const group_b = (uintptr_t) ((list_growth_t const *) b)
+                                  ->list->group;
+    return (group_a > group_b) - (group_a < group_b);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Record that the nodes of list changed from position on. This
+/// invalidates its views (checked in debug builds only) and the part of its
+/// aggregate from position on.
+/// \param  list    The list that changed.
+/// \param  position    The first position whose node or data may differ.
+//  ----------------------------------------------------------------------------
+static void list_changed(linkedlist_t * const list, long const position)
+{
+    snode_destroy(list_tail_detach(list, (position < 0) ? 0 : position));
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Record that the first k nodes of list left its front, by pop, or
+/// moved to its back, by rotation, the others moving k positions down. This
+/// invalidates its views (checked in debug builds only). The aggregate is cut
+/// after its first k positions, which are dropped, or joined at the back if
+/// rotated and all positions are up to date. Either way the remaining
+/// positions stay up to date.
+/// \param  list    The list that changed.
+/// \param  k   Number of nodes that moved, less than the old size.
+/// \param  rotated True if the nodes moved to the back.
+//  ----------------------------------------------------------------------------
+static void list_shifted(linkedlist_t * const list, int const k,
+                         bool const rotated)
+{
+#ifndef NDEBUG
+    list->generation++;
+#endif
+    summary_t * const summary = list->summary;
+    if (summary == NULL) {
+        return;
+    }
+    bool const complete = snode_size(summary->root) == list->size;
+    snode_t *front;
+    snode_split(summary, summary->root, k, &front, &summary->root);
+    if (rotated && complete) {
+        summary->root = snode_join(summary, summary->root, front);
+    } else {
+        snode_destroy(front);
+    }
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Record that the nodes of list from position on are about to be
+/// moved or dropped. This invalidates its views (checked in debug builds only),
+/// and cuts its aggregate at position.
+/// \param  list    The list that changes.
+/// \param  position    The first position whose node moves.
+/// \return The part of the aggregate for the positions from position on that
+/// were up to date, to give to list_tail_attach() or snode_destroy(). NULL if
+/// there is none.
+//  ----------------------------------------------------------------------------
+static snode_t *list_tail_detach(linkedlist_t * const list,
+                                 int const position)
+{
+#ifndef NDEBUG
+    list->generation++;
+#endif
+    summary_t * const summary = list->summary;
+    if (summary == NULL || position >= snode_size(summary->root)) {
+        return NULL;
+    }
+    snode_t *tail;
+    snode_split(summary, summary->root, position, &summary->root, &tail);
+    return tail;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Give list the aggregate of the nodes it received at position, cut
+/// from the list they come from. It is joined if the aggregates are equal and
+/// list is up to date up to position, and dropped otherwise, so that the
+/// positions are mapped again by the next query.
+/// \param  list    The list that received nodes.
+/// \param  position    Position of the first node received.
+/// \param  from    Summary of the list the nodes come from, may be NULL.
+/// \param  tail    Part cut from it by list_tail_detach(), may be NULL.
+//  ----------------------------------------------------------------------------
+static void list_tail_attach(linkedlist_t * const list, int const position,
+                             summary_t const * const from,
+                             snode_t * const tail)
+{
+    summary_t * const summary = list->summary;
+    if (summary != NULL && from != NULL && tail != NULL
+        && snode_size(summary->root) == position
+        && aggregates_equal(&summary->aggregate, &from->aggregate)) {
+        summary->root = snode_join(summary, summary->root, tail);
+    } else {
+        snode_destroy(tail);
+    }
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Assert that the list under view has not changed since the view was
+/// initialized. No-op when NDEBUG is defined.
+/// \param  view    The view to check.
+//  ----------------------------------------------------------------------------
+static void view_check(linkedlist_view_t const * const view)
+{
+    assert(view);
+    assert(view->list);
+    assert(view->generation == view->list->generation);
+    (void) view;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Bring the summary of list up to date: map the data of the stale
+/// positions, walking from the last valid node, and join them to the treap.
+/// They are first built into a treap of their own, in one pass over a stack of
+/// its right spine.
+/// \param  list    The list, with a summary.
+/// \return LINKEDLIST_OK, or an error status.
+//  ----------------------------------------------------------------------------
+static linkedlist_status_t summary_update(linkedlist_t * const list)
+{
+    summary_t * const summary = list->summary;
+    int const valid = snode_size(summary->root);
+    if (valid >= list->size) {
+        return LINKEDLIST_OK;
+    }
+
+    int const count = list->size - valid;
+    snode_t ** const spine = malloc(count * sizeof (snode_t *));
+    if (spine == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+    }
+
+    node_t const *walker = list->head;
+    if (valid > 0) {
+        snode_t const *last = summary->root;
+        while (last->right != NULL) {
+            last = last->right;
+        }
+        walker = last->node->next;
+    }
+
+    // The nodes popped off the spine are complete, and can be pulled.
+    int depth = 0;
+    for (int i = 0; i < count; i++) {
+        snode_t * const snode = snode_create(summary, walker);
+        if (snode == NULL) {
+            if (depth > 0) {
+                snode_destroy(spine[0]);
+            }
+            free(spine);
+            return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+        }
+        snode_t *popped = NULL;
+        while (depth > 0 && spine[depth - 1]->priority < snode->priority) {
+            popped = spine[--depth];
+            snode_pull(summary, popped);
+        }
+        snode->left = popped;
+        if (depth > 0) {
+            spine[depth - 1]->right = snode;
+        }
+        spine[depth++] = snode;
+        walker = walker->next;
+    }
+    while (depth > 1) {
+        snode_pull(summary, spine[--depth]);
+    }
+    snode_pull(summary, spine[0]);
+
+    summary->root = snode_join(summary, summary->root, spine[0]);
+    free(spine);
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Map the data of a position again. Positions that are not up to
+/// date are left to the next query.
+/// \param  summary The summary to update.
+/// \param  position    The position.
+//  ----------------------------------------------------------------------------
+static void summary_position_update(summary_t * const summary,
+                                    int const position)
+{
+    if (position < 0 || position >= snode_size(summary->root)) {
+        return;
+    }
+    snode_update(summary, summary->root, position);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Check if two aggregates compute the same values, so that values
+/// computed for one are valid for the other.
+/// \param  a   First aggregate.
+/// \param  b   Second aggregate.
+/// \return True if they have the same functions, value size and identity.
+//  ----------------------------------------------------------------------------
+static bool aggregates_equal(linkedlist_aggregate_t const * const a,
+                             linkedlist_aggregate_t const * const b)
+{
+    return a->value_size == b->value_size
+        && a->map == b->map
+        && a->combine == b->combine
+        && memcmp(a->identity, b->identity, a->value_size) == 0;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Free a summary and its treap.
+/// \param  summary The summary to free, may be NULL.
+//  ----------------------------------------------------------------------------
+static void summary_destroy(summary_t *summary)
+{
+    if (summary == NULL) {
+        return;
+    }
+    snode_destroy(summary->root);
+    free(summary->values);
+    free(summary);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Allocate a treap node for a list node, and map its data.
+/// \param  summary The summary the treap node is for.
+/// \param  node    The list node.
+/// \return The new treap node, of size 1. NULL if out of memory.
+//  ----------------------------------------------------------------------------
+static snode_t *snode_create(summary_t * const summary,
+                             node_t const * const node)
+{
+    size_t const value_size = summary->aggregate.value_size;
+    snode_t * const snode = malloc(sizeof (snode_t) + 2 * value_size);
+    if (snode == NULL) {
+        return NULL;
+    }
+    snode->left = NULL;
+    snode->right = NULL;
+    snode->node = node;
+    snode->size = 1;
+    snode->priority = priority_next();
+    summary->aggregate.map(node->data, snode->values);
+    memcpy(snode_total(summary, snode), snode->values, value_size);
+    return snode;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \return The number of positions in tree, 0 if NULL.
+//  ----------------------------------------------------------------------------
+static int snode_size(snode_t const * const tree)
+{
+    return (tree != NULL) ? tree->size : 0;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \return The aggregate of the subtree of tree.
+//  ----------------------------------------------------------------------------
+static unsigned char *snode_total(summary_t const * const summary,
+                                  snode_t * const tree)
+{
+    return &tree->values[summary->aggregate.value_size];
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Recompute the size and aggregate of tree from its children.
+/// \param  summary The summary of the treap.
+/// \param  tree    A treap node, whose children are up to date.
+//  ----------------------------------------------------------------------------
+static void snode_pull(summary_t * const summary, snode_t * const tree)
+{
+    size_t const value_size = summary->aggregate.value_size;
+    unsigned char * const tmp = &summary->values[value_size];
+    unsigned char * const total = snode_total(summary, tree);
+
+    tree->size = 1 + snode_size(tree->left) + snode_size(tree->right);
+    if (tree->left != NULL) {
+        summary->aggregate.combine(snode_total(summary, tree->left),
+                                   tree->values, tmp);
+    } else {
+        memcpy(tmp, tree->values, value_size);
+    }
+    if (tree->right != NULL) {
+        summary->aggregate.combine(tmp, snode_total(summary, tree->right),
+                                   total);
+    } else {
+        memcpy(total, tmp, value_size);
+    }
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Split tree after its first k positions. Costs O(log n).
+/// \param  summary The summary of the treap.
+/// \param  tree    The treap to split, may be NULL.
+/// \param  k   Number of positions to put in left.
+/// \param  left    Where to write the treap of the first k positions.
+/// \param  right   Where to write the treap of the others.
+//  ----------------------------------------------------------------------------
+static void snode_split(summary_t * const summary, snode_t * const tree,
+                        int const k, snode_t ** const left,
+                        snode_t ** const right)
 {
-    node_t *walker = start;
-    for (int i = 0; i < pos; i++) {
-        if (walker->next != NULL) {
-            walker = walker->next;
-        } else {
-            // wrap around.
-            walker = start;
+    if (tree == NULL) {
+        *left = NULL;
+        *right = NULL;
+        return;
+    }
+    int const left_size = snode_size(tree->left);
+    if (k <= left_size) {
+        snode_split(summary, tree->left, k, left, &tree->left);
+        *right = tree;
+    } else {
+        snode_split(summary, tree->right, k - left_size - 1,
+                    &tree->right, right);
+        *left = tree;
+    }
+    snode_pull(summary, tree);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Join two treaps, all positions of a coming before those of b.
+/// Costs O(log n).
+/// \param  summary The summary of the treaps.
+/// \param  a   First treap, may be NULL.
+/// \param  b   Second treap, may be NULL.
+/// \return The joined treap.
+//  ----------------------------------------------------------------------------
+static snode_t *snode_join(summary_t * const summary, snode_t * const a,
+                           snode_t * const b)
+{
+    if (a == NULL) {
+        return b;
+    }
+    if (b == NULL) {
+        return a;
+    }
+    if (a->priority > b->priority) {
+        a->right = snode_join(summary, a->right, b);
+        snode_pull(summary, a);
+        return a;
+    }
+    b->left = snode_join(summary, a, b->left);
+    snode_pull(summary, b);
+    return b;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Map the data of a position again, and recompute the aggregates on
+/// the way back up. Costs O(log n).
+/// \param  summary The summary of the treap.
+/// \param  tree    The treap, holding position.
+/// \param  position    Position in tree.
+//  ----------------------------------------------------------------------------
+static void snode_update(summary_t * const summary, snode_t * const tree,
+                         int const position)
+{
+    int const left_size = snode_size(tree->left);
+    if (position < left_size) {
+        snode_update(summary, tree->left, position);
+    } else if (position > left_size) {
+        snode_update(summary, tree->right, position - left_size - 1);
+    } else {
+        summary->aggregate.map(tree->node->data, tree->values);
+    }
+    snode_pull(summary, tree);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Combine result with the values of the positions [start, end) of
+/// tree, in order. Whole subtrees in the range are combined from their
+/// aggregate, so that O(log n) nodes are visited.
+/// \param  summary The summary of the treap.
+/// \param  tree    The treap, may be NULL.
+/// \param  start   First position in tree, may be negative.
+/// \param  end One past the last position, may be beyond the size of tree.
+/// \param  result  The value to combine with, updated.
+//  ----------------------------------------------------------------------------
+static void snode_fold(summary_t * const summary, snode_t * const tree,
+                       int const start, int const end,
+                       unsigned char * const result)
+{
+    if (tree == NULL || start >= end || end <= 0 || start >= tree->size) {
+        return;
+    }
+
+    size_t const value_size = summary->aggregate.value_size;
+    unsigned char * const tmp = &summary->values[value_size];
+    if (start <= 0 && end >= tree->size) {
+        summary->aggregate.combine(result, snode_total(summary, tree), tmp);
+        memcpy(result, tmp, value_size);
+        return;
+    }
+
+    int const left_size = snode_size(tree->left);
+    snode_fold(summary, tree->left, start, end, result);
+    if (start <= left_size && left_size < end) {
+        summary->aggregate.combine(result, tree->values, tmp);
+        memcpy(result, tmp, value_size);
+    }
+    snode_fold(summary, tree->right, start - left_size - 1,
+               end - left_size - 1, result);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Free a treap.
+/// \param  tree    The treap, may be NULL.
+//  ----------------------------------------------------------------------------
+static void snode_destroy(snode_t *tree)
+{
+    while (tree != NULL) {
+        snode_destroy(tree->left);
+        snode_t * const right = tree->right;
+        free(tree);
+        tree = right;
+    }
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Draw the priority of a new treap node: the next count, mixed by the
+/// finalizer of splitmix64 so that priorities look random.
+/// \return The priority.
+//  ----------------------------------------------------------------------------
+static unsigned long long priority_next(void)
+{
+    unsigned long long x = __atomic_add_fetch(&priority_count, 1,
+                                              __ATOMIC_RELAXED);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Link the data of payload after the tail of dst, in a new node. If
+/// dst has an intern table and the data are not shared yet, they are handed
+/// over to the table. A full circular list first frees its head to make room.
+/// \param  dst The list to append to.
+/// \param  payload Node whose data and entry are taken over on success.
+/// \return LINKEDLIST_OK, LINKEDLIST_FULL, LINKEDLIST_OVER_BUDGET, or an error
+/// status.
+//  ----------------------------------------------------------------------------
+static linkedlist_status_t list_append(linkedlist_t * const dst,
+                                       node_t const * const payload)
+{
+    // Sliding window: the oldest element makes room for the new one.
+    bool const evict = dst->capacity != 0 && dst->size >= (int) dst->capacity;
+    if (!evict) {
+        if (dst->size >= LINKEDLIST_MAX_SIZE) {
+            // Max reached, which is not an error. Do nothing.
+            return LINKEDLIST_FULL;
+        }
+        long long const growth = memory_growth(dst, dst->size + 1,
+                                               dst->data_size);
+        if (!budget_allows(dst, growth, growth)) {
+            return LINKEDLIST_OVER_BUDGET;
         }
     }
-    return walker;
+
+    // Create a whole new node.
+    node_t *new_node_p = malloc(sizeof (node_t));
+    if (new_node_p == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+    }
+    *new_node_p = (node_t) {
+        .data = payload->data,
+        .entry = payload->entry,
+        .next = NULL
+    };
+    if (new_node_p->entry == NULL && dst->intern != NULL
+        && new_node_p->data != NULL) {
+        intern_entry_t * const entry = intern_get(dst->intern, payload->data,
+                                                  (void *) payload->data);
+        if (entry == NULL) {
+            free(new_node_p);
+            return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+        }
+        new_node_p->entry = entry;
+        new_node_p->data = entry->data;
+    }
+
+    if (evict) {
+        nodes_recursive_destroy(list_unlink_head(dst));
+    }
+    if (dst->head == NULL) {
+        // NULL head means this list was empty.
+        dst->head = new_node_p;
+    } else {
+        dst->tail->next = new_node_p;
+    }
+    dst->tail = new_node_p;
+    list_size_set(dst, dst->size + 1);
+    list_changed(dst, dst->size - 1);
+    return LINKEDLIST_OK;
 }
 
 
 //  ----------------------------------------------------------------------------
-/// \brief  Truncate the list after position limit.
-/// \param  list    The list to truncate.
-/// \param  limit   The max size of the resulting list.
+/// \brief  Unlink the head node of a non-empty list.
+/// \param  list    The list.
+/// \return The old head, with its data, to be freed by the caller.
 //  ----------------------------------------------------------------------------
-static void length_limit(linkedlist_t * const list, int const limit)
+static node_t *list_unlink_head(linkedlist_t * const list)
+{
+    node_t * const old_head = list->head;
+
+    list->head = old_head->next;
+    if (list->head == NULL) {
+        list->tail = NULL;
+    }
+    old_head->next = NULL;
+    list_size_set(list, list->size - 1);
+    list_shifted(list, 1, false);
+    return old_head;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Check if the data of two nodes differ. Data interned in the same
+/// table are equal only if they are the same entry, so they are not read.
+/// \param  a   First node.
+/// \param  b   Second node.
+/// \param  data_size   The size of the data.
+/// \return True if at least one byte differs.
+//  ----------------------------------------------------------------------------
+static bool nodes_differ(node_t const * const a, node_t const * const b,
+                         size_t const data_size)
+{
+    if (a->entry != NULL && b->entry != NULL
+        && a->entry->table == b->entry->table) {
+        return a->entry != b->entry;
+    }
+    return payload_differs(a->data, b->data, data_size);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Give to its own copy of the data of from. Without a table, the
+/// copy is a new allocation owned by to. With a table, to shares the entry of
+/// equal data, looked up by hash unless from already shares one of table.
+/// NULL data are copied as NULL, and never shared.
+/// \param  to  Node without data.
+/// \param  from    Node to copy the data of.
+/// \param  data_size   The size of the data.
+/// \param  table   Intern table of to, NULL for owned data.
+/// \return False if out of memory, to is left without data.
+//  ----------------------------------------------------------------------------
+static bool node_data_copy(node_t * const to, node_t const * const from,
+                           size_t const data_size,
+                           linkedlist_intern_t * const table)
+{
+    if (from->data == NULL) {
+        to->data = NULL;
+        return true;
+    }
+    if (table == NULL) {
+        void *new_data = malloc(data_size);
+        if (new_data == NULL) {
+            return false;
+        }
+        memcpy(new_data, from->data, data_size);
+        to->data = new_data;
+        return true;
+    }
+
+    assert(data_size == table->data_size);
+    intern_entry_t *entry = from->entry;
+    if (entry != NULL && entry->table == table) {
+        // from holds a reference, the entry cannot go away meanwhile.
+        __atomic_add_fetch(&entry->refcount, 1, __ATOMIC_RELAXED);
+    } else {
+        entry = intern_get(table, from->data, NULL);
+        if (entry == NULL) {
+            return false;
+        }
+    }
+    to->entry = entry;
+    to->data = entry->data;
+    return true;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Free the data of a node, or release its share of interned data.
+/// \param  node    The node, left without data.
+//  ----------------------------------------------------------------------------
+static void node_data_release(node_t * const node)
+{
+    if (node->entry != NULL) {
+        intern_release(node->entry);
+    } else {
+        free((void *) node->data);
+    }
+    node->data = NULL;
+    node->entry = NULL;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Give a node its own copy of its shared data, so that it can be
+/// written without changing the other lists nor the entry it was hashed as.
+/// \param  node    The node, with owned or shared data.
+/// \return False if out of memory, the node keeps its shared data.
+//  ----------------------------------------------------------------------------
+static bool node_unshare(node_t * const node)
+{
+    if (node->entry == NULL) {
+        return true;
+    }
+    size_t const data_size = node->entry->table->data_size;
+    void * const data = malloc(data_size);
+    if (data == NULL) {
+        return false;
+    }
+    memcpy(data, node->data, data_size);
+    intern_release(node->entry);
+    node->entry = NULL;
+    node->data = data;
+    return true;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  FNV-1a hash of the bytes of data.
+/// \param  data    The data to hash.
+/// \param  data_size   The size of the data.
+/// \return The hash.
+//  ----------------------------------------------------------------------------
+static size_t intern_hash(void const * const data, size_t const data_size)
+{
+    unsigned char const * const bytes = data;
+    unsigned long long hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < data_size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return (size_t) hash;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Find the entry of the table holding data equal to data.
+/// \param  table   The table to search.
+/// \param  data    The data to look for.
+/// \param  hash    intern_hash() of data.
+/// \return The entry, NULL if none.
+/// \attention  The lock of table must be held.
+//  ----------------------------------------------------------------------------
+static intern_entry_t *intern_lookup(linkedlist_intern_t * const table,
+                                     void const * const data,
+                                     size_t const hash)
+{
+    intern_entry_t *entry = table->buckets[hash & (table->nb_buckets - 1)];
+    while (entry != NULL) {
+        if (entry->hash == hash
+            && memcmp(entry->data, data, table->data_size) == 0) {
+            return entry;
+        }
+        entry = entry->next;
+    }
+    return NULL;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Add a new entry to the table, taking over data. The buckets are
+/// doubled when the table gets 3/4 full; if that fails, the chains just get
+/// longer.
+/// \param  table   The table to add to.
+/// \param  data    Dynamically allocated data, not in the table yet.
+/// \param  hash    intern_hash() of data.
+/// \return The new entry, with one reference. NULL if out of memory.
+/// \attention  The lock of table must be held.
+//  ----------------------------------------------------------------------------
+static intern_entry_t *intern_insert(linkedlist_intern_t * const table,
+                                     void * const data,
+                                     size_t const hash)
+{
+    if (table->nb_entries + 1 > table->nb_buckets / 4 * 3) {
+        size_t const nb_buckets = 2 * table->nb_buckets;
+        intern_entry_t **buckets = calloc(nb_buckets,
+                                          sizeof (intern_entry_t *));
+        if (buckets != NULL) {
+            for (size_t i = 0; i < table->nb_buckets; i++) {
+                intern_entry_t *entry = table->buckets[i];
+                while (entry != NULL) {
+                    intern_entry_t * const next = entry->next;
+                    size_t const bucket = entry->hash & (nb_buckets - 1);
+                    entry->next = buckets[bucket];
+                    buckets[bucket] = entry;
+                    entry = next;
+                }
+            }
+            free(table->buckets);
+            table->buckets = buckets;
+            table->nb_buckets = nb_buckets;
+        }
+    }
+
+    intern_entry_t * const entry = malloc(sizeof (intern_entry_t));
+    if (entry == NULL) {
+        return NULL;
+    }
+    size_t const bucket = hash & (table->nb_buckets - 1);
+    *entry = (intern_entry_t) {
+        .data = data,
+        .hash = hash,
+        .refcount = 1,
+        .table = table,
+        .next = table->buckets[bucket]
+    };
+    table->buckets[bucket] = entry;
+    __atomic_add_fetch(&table->nb_entries, 1, __ATOMIC_RELAXED);
+    memory_account(NULL, table->data_size);
+    return entry;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Take a reference on the entry of the table equal to data, adding
+/// one if there is none. The new entry holds adopted if given, otherwise a copy
+/// of data.
+/// \param  table   The table.
+/// \param  data    The data to look for.
+/// \param  adopted Dynamically allocated data equal to data, freed if an entry
+/// exists. May be NULL.
+/// \return The entry, NULL if out of memory; adopted is then left to the
+/// caller.
+//  ----------------------------------------------------------------------------
+static intern_entry_t *intern_get(linkedlist_intern_t * const table,
+                                  void const * const data,
+                                  void * const adopted)
+{
+    size_t const hash = intern_hash(data, table->data_size);
+
+    intern_lock(table);
+    intern_entry_t *entry = intern_lookup(table, data, hash);
+    if (entry != NULL) {
+        __atomic_add_fetch(&entry->refcount, 1, __ATOMIC_RELAXED);
+        intern_unlock(table);
+        free(adopted);
+        return entry;
+    }
+
+    void *new_data = adopted;
+    if (new_data == NULL) {
+        new_data = malloc(table->data_size);
+        if (new_data != NULL) {
+            memcpy(new_data, data, table->data_size);
+        }
+    }
+    if (new_data != NULL) {
+        entry = intern_insert(table, new_data, hash);
+        if (entry == NULL && adopted == NULL) {
+            free(new_data);
+        }
+    }
+    intern_unlock(table);
+    return entry;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Drop one reference to an entry, and remove it from its table with
+/// its data when none are left. References other than the last are dropped
+/// without the lock. The last one is dropped with the lock held, so that no
+/// lookup can take a new reference while the entry is being removed.
+/// \param  entry   The entry.
+//  ----------------------------------------------------------------------------
+static void intern_release(intern_entry_t * const entry)
 {
-    if (limit <= list->size) {
+    unsigned long refcount = __atomic_load_n(&entry->refcount,
+                                             __ATOMIC_RELAXED);
+    assert(refcount > 0);
+    while (refcount > 1) {
+        if (__atomic_compare_exchange_n(&entry->refcount, &refcount,
+                                        refcount - 1, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+            return;
+        }
+    }
+
+    linkedlist_intern_t * const table = entry->table;
+    intern_lock(table);
+    if (__atomic_sub_fetch(&entry->refcount, 1, __ATOMIC_ACQ_REL) > 0) {
+        // Taken again by a lookup meanwhile.
+        intern_unlock(table);
         return;
     }
+    intern_entry_t **link = &table->buckets[entry->hash
+                                            & (table->nb_buckets - 1)];
+    while (*link != entry) {
+        link = &(*link)->next;
+    }
+    *link = entry->next;
+    __atomic_sub_fetch(&table->nb_entries, 1, __ATOMIC_RELAXED);
+    intern_unlock(table);
+    memory_account(NULL, -(long long) table->data_size);
 
-    node_t *walker = nodes_walker(list->head, limit - 1);
-    nodes_recursive_destroy(walker->next);
-    walker->next = NULL;
-    list->size = limit;
+    free(entry->data);
+    free(entry);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Take the lock of the table, spinning until it is free. It is held
+/// for a lookup or an insertion only.
+/// \param  table   The table.
+//  ----------------------------------------------------------------------------
+static void intern_lock(linkedlist_intern_t * const table)
+{
+    while (__atomic_test_and_set(&table->lock, __ATOMIC_ACQUIRE)) {
+        // Spin.
+    }
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Release the lock of the table.
+/// \param  table   The table.
+//  ----------------------------------------------------------------------------
+static void intern_unlock(linkedlist_intern_t * const table)
+{
+    __atomic_clear(&table->lock, __ATOMIC_RELEASE);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Write the data of from over that of to. Owned data are written in
+/// place; shared data are released, and to gets a copy like
+/// node_data_copy(), as it does when interning.
+/// \param  to  Node to write to, with or without data.
+/// \param  from    Node to copy the data of.
+/// \param  data_size   The size of the data.
+/// \param  table   Intern table of to, NULL for owned data.
+/// \return False if out of memory, to is left without data.
+//  ----------------------------------------------------------------------------
+static bool node_data_set(node_t * const to, node_t const * const from,
+                          size_t const data_size,
+                          linkedlist_intern_t * const table)
+{
+    if (to->entry != NULL || table != NULL || from->data == NULL) {
+        // Shared data are not written over but released.
+        node_data_release(to);
+    }
+    if (to->data != NULL) {
+        memcpy((void *) to->data, from->data, data_size);
+        return true;
+    }
+    return node_data_copy(to, from, data_size, table);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Empty the delta, keeping its arrays, and set its sizes.
+/// \param  delta   The delta.
+/// \param  data_size   The size of one data.
+/// \param  base_size   The size of the list the delta applies to.
+/// \param  size    The size of the list after patching.
+//  ----------------------------------------------------------------------------
+static void delta_reset(linkedlist_delta_t * const delta,
+                        size_t const data_size,
+                        int const base_size,
+                        int const size)
+{
+    delta->data_size = data_size;
+    delta->base_size = base_size;
+    delta->size = size;
+    delta->nb_ranges = 0;
+    delta->payloads_used = 0;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Make room in the delta for the data at position, which must come
+/// after the positions already held. It extends the last range if position
+/// follows it, otherwise opens a new range. The arrays are doubled when full.
+/// \param  delta   The delta.
+/// \param  position    The position of the data.
+/// \return Where to write data_size bytes of data, NULL if out of memory.
+//  ----------------------------------------------------------------------------
+static unsigned char *delta_payload_reserve(linkedlist_delta_t * const delta,
+                                            int const position)
+{
+    delta_range_t *last = (delta->nb_ranges > 0)
+                          ? &delta->ranges[delta->nb_ranges - 1] : NULL;
+    if (last == NULL || last->start + last->count != position) {
+        if (delta->nb_ranges == delta->max_ranges) {
+            int const max_ranges = (delta->max_ranges > 0)
+                                   ? 2 * delta->max_ranges : 16;
+            delta_range_t *ranges = realloc(delta->ranges,
+                                            max_ranges
+                                            * sizeof (delta_range_t));
+            if (ranges == NULL) {
+                return NULL;
+            }
+            delta->ranges = ranges;
+            delta->max_ranges = max_ranges;
+        }
+        last = &delta->ranges[delta->nb_ranges];
+        *last = (delta_range_t) {
+            .start = position,
+            .count = 0,
+            .offset = delta->payloads_used
+        };
+        delta->nb_ranges++;
+    }
+
+    if (delta->payloads_used + delta->data_size > delta->payloads_max) {
+        size_t max = (delta->payloads_max > 0)
+                     ? 2 * delta->payloads_max : 16 * delta->data_size;
+        while (max < delta->payloads_used + delta->data_size) {
+            max *= 2;
+        }
+        unsigned char *payloads = realloc(delta->payloads, max);
+        if (payloads == NULL) {
+            return NULL;
+        }
+        delta->payloads = payloads;
+        delta->payloads_max = max;
+    }
+
+    unsigned char * const payload = &delta->payloads[delta->payloads_used];
+    delta->payloads_used += delta->data_size;
+    last->count++;
+    return payload;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Check that a range read from a stream may follow the ranges of the
+/// delta: after them, within the final size, and not empty.
+/// \param  delta   The delta being read.
+/// \param  start   First position of the range.
+/// \param  count   Number of positions.
+/// \return True if valid.
+//  ----------------------------------------------------------------------------
+static bool delta_range_check(linkedlist_delta_t const * const delta,
+                              long const start,
+                              long const count)
+{
+    long end_before = 0;
+    if (delta->nb_ranges > 0) {
+        delta_range_t const * const last = &delta->ranges[delta->nb_ranges
+                                                          - 1];
+        end_before = last->start + last->count;
+    }
+    return count > 0 && start >= end_before && start <= delta->size
+           && count <= delta->size - start;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Write value as 32 bits little endian.
+/// \return False if the stream failed.
+//  ----------------------------------------------------------------------------
+static bool stream_u32_write(FILE * const stream, unsigned long const value)
+{
+    unsigned char const bytes[4] = {
+        value & 0xFF,
+        (value >> 8) & 0xFF,
+        (value >> 16) & 0xFF,
+        (value >> 24) & 0xFF
+    };
+    return fwrite(bytes, 1, sizeof bytes, stream) == sizeof bytes;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Read a 32 bits little endian value.
+/// \return False if the stream failed or ended.
+//  ----------------------------------------------------------------------------
+static bool stream_u32_read(FILE * const stream, unsigned long * const value)
+{
+    unsigned char bytes[4];
+    if (fread(bytes, 1, sizeof bytes, stream) != sizeof bytes) {
+        return false;
+    }
+    *value = (unsigned long) bytes[0]
+             | (unsigned long) bytes[1] << 8
+             | (unsigned long) bytes[2] << 16
+             | (unsigned long) bytes[3] << 24;
+    return true;
 }
@@ -7,14 +7,74 @@ Copyright (c) 2013 Gauthier Fleutot Ostervall
 
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdio.h>
 
 // Sizes are saved as int, make sure this MAX_SIZE is under INT_MAX.
 #define LINKEDLIST_MAX_SIZE (5000U)
 
+// Status codes returned by the functions that can fail. The last error is also
+// saved per thread, see linkedlist_last_error_get().
+typedef enum {
+    LINKEDLIST_OK = 0,
+    LINKEDLIST_FULL,            // Max size reached, not an error.
+    LINKEDLIST_OVER_BUDGET,     // Memory budget reached, not an error.
+    LINKEDLIST_ERR_NULL,        // A required pointer parameter was NULL.
+    LINKEDLIST_ERR_NO_MEMORY,   // An allocation failed.
+    LINKEDLIST_ERR_NO_AGGREGATE,    // No aggregate set on the list.
+    LINKEDLIST_ERR_MISMATCH,    // Data sizes differ, or wrong list for a delta.
+    LINKEDLIST_ERR_IO,          // A stream failed or held malformed data.
+} linkedlist_status_t;
+
+// Function called on each error, when installed with linkedlist_log_hook_set().
+typedef void (*linkedlist_log_hook_t)(linkedlist_status_t status,
+                                      char const *func);
+
+// Function called on the data of the nodes by linkedlist_fold() and the
+// searches, with the context pointer given by the caller. See each function
+// for the meaning of the returned value.
+typedef bool (*linkedlist_visitor_t)(void const * const data,
+                                     void * const context);
+
 // Do not create your own linkedlist_t variables, use the function
 // linkedlist_create().
 typedef struct linkedlist_s linkedlist_t;
 
+// Lists sharing a memory budget, see linkedlist_group_create().
+typedef struct linkedlist_group_s linkedlist_group_t;
+
+// Table of data shared between lists, see linkedlist_intern_create().
+typedef struct linkedlist_intern_s linkedlist_intern_t;
+
+// Differences between two lists, see linkedlist_diff().
+typedef struct linkedlist_delta_s linkedlist_delta_t;
+
+// Non-owning view on the range [start, end) of a list. Views are meant to be
+// put on the stack; do not access the members directly, use the
+// linkedlist_view_*() functions. A view is invalidated by any change to the
+// nodes of its list (add, copy, cross...). Writing data through handles does
+// not invalidate it. Debug builds assert on use of an invalidated view.
+typedef struct {
+    linkedlist_t *list;
+    void *first;                // First node of the range.
+    int start;
+    int end;
+    unsigned long generation;   // Generation of list when initialized.
+} linkedlist_view_t;
+
+// Monoid kept up to date over the data of a list, see
+// linkedlist_aggregate_set(). combine must be associative with identity as
+// neutral element; it need not be commutative.
+typedef struct {
+    size_t value_size;      // Size of one value in bytes.
+    void const *identity;   // Neutral value, copied when set.
+    // Compute into value the value of one data.
+    void (*map)(void const * const data, void * const value);
+    // Compute into result the combination of a followed by b. result does not
+    // alias a or b.
+    void (*combine)(void const * const a, void const * const b,
+                    void * const result);
+} linkedlist_aggregate_t;
+
 //  ----------------------------------------------------------------------------
 /// \brief  Create a new empty list.
 /// \return Pointer to the new list.
@@ -22,17 +82,58 @@ typedef struct linkedlist_s linkedlist_t;
 linkedlist_t *linkedlist_create(void);
 
 
+//  ----------------------------------------------------------------------------
+/// \brief  Create a new empty circular list, holding at most capacity
+/// elements. Adding to a full circular list frees the data at the head to make
+/// room, which makes it usable as a sliding window or ring buffer. Copies,
+/// crosses and splits into a circular list truncate it to its capacity, like
+/// other lists to LINKEDLIST_MAX_SIZE.
+/// \param  capacity Max number of elements. 0 or values above
+/// LINKEDLIST_MAX_SIZE give LINKEDLIST_MAX_SIZE.
+/// \return Pointer to the new list.
+//  ----------------------------------------------------------------------------
+linkedlist_t *linkedlist_circular_create(unsigned int const capacity);
+
+
 //  ----------------------------------------------------------------------------
 /// \brief  Link a new node at the end of the destination list.
 /// \param  dst Destination list.
 /// \param  data Pointer to the data content of the new node. Memory must be
 /// dynamically allocated.
-/// \return The updated list. This is useful if dst was empty before calling
-/// this function.
+/// \return LINKEDLIST_OK, LINKEDLIST_FULL if the list already held
+/// LINKEDLIST_MAX_SIZE elements, or LINKEDLIST_OVER_BUDGET if adding would
+/// exceed the memory budget of dst or its group. Data is not linked unless
+/// LINKEDLIST_OK.
 /// \attention  The data object pointed to by data must be allocated
 /// dynamically. Addresses to auto or global variables may not be used.
+/// \attention  If dst interns its data (see linkedlist_intern_set()) and equal
+/// data are already in its table, data is freed on LINKEDLIST_OK and the
+/// pointer must not be used anymore. Get the data actually linked with
+/// linkedlist_data_get(dst, linkedlist_size_get(dst) - 1).
 //  ----------------------------------------------------------------------------
-void linkedlist_add(linkedlist_t *dst, void const * const data);
+linkedlist_status_t linkedlist_add(linkedlist_t *dst, void const * const data);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Unlink the first node of the list, in constant time.
+/// \param  list The list to pop from.
+/// \return Pointer to the data of the removed node, NULL if list was empty.
+/// The caller becomes responsible for freeing the data. Interned data are
+/// copied for the caller, NULL if that fails.
+//  ----------------------------------------------------------------------------
+void *linkedlist_pop_front(linkedlist_t * const list);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Rotate the list so that the node at position k becomes the head.
+/// k is reduced modulo the size, negative values rotate the other way. No
+/// data is moved, only links. Rotating by 1 is constant time, in general the
+/// cost is (k modulo size) steps.
+/// \param  list The list to rotate.
+/// \param  k Position of the new head.
+/// \return LINKEDLIST_OK, or an error status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_rotate(linkedlist_t * const list, int const k);
 
 
 // ----------------------------------------------------------------------------
@@ -48,38 +149,116 @@ void linkedlist_destroy(linkedlist_t *list);
 /// \brief Copy the src list to a new dst list. If dst is not an empty list, its
 /// content is destroyed before the copy operation. No memory used by the nodes
 /// or the data of src is reused for dst. The nodes and data of dst are
-/// allocated in this copy function (and freed on destroy).
+/// allocated in this copy function (and freed on destroy), unless dst interns
+/// its data, see linkedlist_intern_set().
 /// \param dst Pointer to the list to copy to.
 /// \param src Pointer to the list to copy.
 /// \param data_size The size of one data slot.
+/// \return LINKEDLIST_OK, or an error status.
 // ----------------------------------------------------------------------------
-void linkedlist_copy(linkedlist_t *dst, linkedlist_t *src,
-                     size_t const data_size);
+linkedlist_status_t linkedlist_copy(linkedlist_t *dst, linkedlist_t *src,
+                                    size_t const data_size);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief Copy the src list to each of the dst lists, walking src only once.
+/// Unlike linkedlist_copy(), the nodes and data already in each dst are
+/// reused and overwritten, only missing nodes are allocated and only nodes in
+/// excess are destroyed.
+/// \param dsts Array of nb_dsts lists to copy to. src may not be one of them.
+/// \param nb_dsts Number of lists in dsts.
+/// \param src Pointer to the list to copy.
+/// \param data_size The size of one data slot.
+/// \return LINKEDLIST_OK, or an error status.
+/// \attention The data already in the dst lists must be at least data_size
+/// bytes large, as they are when made by copies with the same data_size.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_copy_many(linkedlist_t * const dsts[],
+                                         int const nb_dsts,
+                                         linkedlist_t * const src,
+                                         size_t const data_size);
 
 
 //  ----------------------------------------------------------------------------
 /// \brief  Run the callback function passed as parameter on the data of all
 /// nodes in the list passed as parameter. The callback may modify the data,
-/// since the data itself is held by the client module.
+/// since the data itself is held by the client module, unless interned:
+/// shared data are passed as they are, for reading only. Write them through
+/// linkedlist_data_handle_get() or linkedlist_data_set() instead.
 /// \param  list The list to run the callback on.
 /// \param  callback Function pointer to the function to run on data.
+/// \return LINKEDLIST_OK, or an error status.
 //  ----------------------------------------------------------------------------
-void linkedlist_run_for_all(linkedlist_t *list,
-                            void (*callback)(void const * const data));
+linkedlist_status_t linkedlist_run_for_all(
+    linkedlist_t *list,
+    void (*callback)(void const * const data));
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Run callback on the data of the nodes of list in order, passing
+/// context along, until callback returns false. The result accumulates in
+/// context, e.g. a sum or an array being filled.
+/// \param  list The list to fold.
+/// \param  callback Function to run on data, returns false to stop.
+/// \param  context Passed as is to callback, may be NULL.
+/// \return LINKEDLIST_OK, or an error status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_fold(linkedlist_t * const list,
+                                    linkedlist_visitor_t const callback,
+                                    void * const context);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Find the first data of list for which predicate is true. The
+/// traversal stops there, so a hit at position k costs O(k).
+/// \param  list The list to search.
+/// \param  predicate Function to run on data.
+/// \param  context Passed as is to predicate, may be NULL.
+/// \param  position Where to write the position of the data found, or -1. May
+/// be NULL.
+/// \return Handle to the data found, NULL if none or on error. Interned data
+/// are copied for the node like by linkedlist_data_handle_get().
+//  ----------------------------------------------------------------------------
+void *linkedlist_find_first(linkedlist_t * const list,
+                            linkedlist_visitor_t const predicate,
+                            void * const context,
+                            int * const position);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Check if predicate is true for at least one data of list, stopping
+/// at the first one.
+/// \return True if found, false if not, for an empty list or on error.
+//  ----------------------------------------------------------------------------
+bool linkedlist_any(linkedlist_t * const list,
+                    linkedlist_visitor_t const predicate,
+                    void * const context);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Check if predicate is true for all data of list, stopping at the
+/// first one for which it is false.
+/// \return True if so, or for an empty list. False if not or on error.
+//  ----------------------------------------------------------------------------
+bool linkedlist_all(linkedlist_t * const list,
+                    linkedlist_visitor_t const predicate,
+                    void * const context);
 
 
 //  ----------------------------------------------------------------------------
 /// \brief  Copy the list from position (0 is head) to its end, into
 /// sublist. New nodes are created, there are no nodes being pointed to twice.
+/// position is reduced modulo the size of list.
 /// \param  list The list to copy from.
 /// \param  sublist The list to copy to. Overwritten if not empty.
 /// \param  position Where to start copying from in list.
 /// \param  data_size The size in bytes of one data object.
+/// \return LINKEDLIST_OK, or an error status.
 //  ----------------------------------------------------------------------------
-void linkedlist_sublist_copy(linkedlist_t * const sublist,
-                             linkedlist_t * const list,
-                             unsigned int const position,
-                             size_t const data_size);
+linkedlist_status_t linkedlist_sublist_copy(linkedlist_t * const sublist,
+                                            linkedlist_t * const list,
+                                            unsigned int const position,
+                                            size_t const data_size);
 
 
 //  ----------------------------------------------------------------------------
@@ -99,25 +278,493 @@ bool linkedlist_compare(linkedlist_t * const list_a,
 /// \param  pos_a The index to the first node that must move to the other list.
 /// \param  list_b
 /// \param  pos_b The index to the first node that must move to the other list.
+/// \return LINKEDLIST_OK, or an error status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_cross(linkedlist_t * const list_a,
+                                     int const pos_a,
+                                     linkedlist_t * const list_b,
+                                     int const pos_b);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Move all the nodes of src to the end of dst, in constant time. No
+/// data is copied. src is left empty. If dst grows above LINKEDLIST_MAX_SIZE
+/// it is truncated; a circular dst drops its oldest elements instead.
+/// \param  dst The list to append to. If empty, it takes the data size of src
+/// (see linkedlist_data_size_set()).
+/// \param  src The list to move the nodes from. May not be dst.
+/// \return LINKEDLIST_OK, or LINKEDLIST_ERR_MISMATCH if neither list is empty
+/// and their data sizes differ, or another error status.
 //  ----------------------------------------------------------------------------
-void linkedlist_cross(linkedlist_t * const list_a, int const pos_a,
-                      linkedlist_t * const list_b, int const pos_b);
+linkedlist_status_t linkedlist_concat(linkedlist_t * const dst,
+                                      linkedlist_t * const src);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Detach the nodes of list from position (0 is head) to its end, and
+/// move them to out. No data is copied. Costs a walk to position.
+/// \param  list The list to split.
+/// \param  position Index of the first node to move. Nothing moves if it is
+/// at or beyond the end of list.
+/// \param  out The list to move the nodes to. Overwritten if not empty, and
+/// takes the data size of list. May not be list.
+/// \return LINKEDLIST_OK, or an error status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_split(linkedlist_t * const list,
+                                     int const position,
+                                     linkedlist_t * const out);
 
 
 //  ----------------------------------------------------------------------------
 /// \brief  Get the pointer to the data of the node at position. If position
-/// goes beyond the number of elemnts of list, wrap around (go on form head
-/// after reaching tail).
+/// goes beyond the number of elements of list, wrap around (go on from head
+/// after reaching tail). The position is reduced modulo the size first, so
+/// the cost is never more than one lap.
+/// The data may be written through the handle. Interned data are copied for
+/// the node first (copy on write), so that the other lists sharing them are
+/// not changed; use linkedlist_data_get() to only read them.
 /// \param  list The list to explore.
 /// \param  position The index to the node of interest.
+/// \return Pointer to the data, NULL if the list is empty or out of memory.
 //  ----------------------------------------------------------------------------
 void *linkedlist_data_handle_get(linkedlist_t * const list,
                                  unsigned int const position);
 
 
+//  ----------------------------------------------------------------------------
+/// \brief  Same as linkedlist_data_handle_get(), for reading only: interned
+/// data stay shared.
+/// \return Pointer to the data, NULL if the list is empty.
+//  ----------------------------------------------------------------------------
+void const *linkedlist_data_get(linkedlist_t * const list,
+                                unsigned int const position);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Write a copy of data over the data at position, reduced modulo the
+/// size. Shared data are not written over: the node gets new data, interned
+/// again if list interns its data. The aggregate of list is kept up to date.
+/// \param  list The list to write to.
+/// \param  position The index to the node of interest.
+/// \param  data The data to copy.
+/// \param  data_size The size of one data.
+/// \return LINKEDLIST_OK, or an error status. Nothing is done if list is
+/// empty.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_data_set(linkedlist_t * const list,
+                                        unsigned int const position,
+                                        void const * const data,
+                                        size_t const data_size);
+
+
 //  ----------------------------------------------------------------------------
 /// \brief Get the size of the list passed as parameter.
 //  ----------------------------------------------------------------------------
 int linkedlist_size_get(linkedlist_t * const list);
 
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Initialize a view on the range [start, end) of list. Costs a walk
+/// to start, does not allocate and does not copy any data. end is clamped to
+/// the size of list.
+/// \param  view The view to initialize.
+/// \param  list The list to view.
+/// \param  start Index of the first node in the view.
+/// \param  end Index after the last node in the view.
+//  ----------------------------------------------------------------------------
+void linkedlist_view_init(linkedlist_view_t * const view,
+                          linkedlist_t * const list,
+                          int const start,
+                          int const end);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the number of elements in the view.
+//  ----------------------------------------------------------------------------
+int linkedlist_view_size_get(linkedlist_view_t const * const view);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Same as linkedlist_run_for_all(), on the range of the view only.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_view_run_for_all(
+    linkedlist_view_t const * const view,
+    void (*callback)(void const * const data));
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Compare the content of two views (values of data, not pointers).
+/// \return True if the views have the same size and their data were equal.
+//  ----------------------------------------------------------------------------
+bool linkedlist_view_compare(linkedlist_view_t const * const view_a,
+                             linkedlist_view_t const * const view_b,
+                             size_t const data_size);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the pointer to the data at position in the view (0 is the
+/// start of the view). position wraps around within the view. Interned data
+/// are copied like by linkedlist_data_handle_get().
+/// \return Pointer to the data, NULL if the view is empty or out of memory.
+//  ----------------------------------------------------------------------------
+void *linkedlist_view_data_handle_get(linkedlist_view_t const * const view,
+                                      unsigned int const position);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Copy the range of the view into dst. dst is overwritten if not
+/// empty, and must not be the list under view.
+/// \param  dst The list to copy to.
+/// \param  view The range to copy.
+/// \param  data_size The size in bytes of one data object.
+/// \return LINKEDLIST_OK, or an error status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_view_copy(linkedlist_t * const dst,
+                                         linkedlist_view_t const * const view,
+                                         size_t const data_size);
+
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Count the positions at which two lists have different data. Data
+/// are compared by value, on data_size bytes. Positions beyond the end of the
+/// shorter list all count as different.
+/// \param  list_a
+/// \param  list_b
+/// \param  data_size The size in bytes of one data object.
+/// \param  distance Where to write the result.
+/// \return LINKEDLIST_OK, or an error status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_distance(linkedlist_t * const list_a,
+                                        linkedlist_t * const list_b,
+                                        size_t const data_size,
+                                        int * const distance);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Same as linkedlist_distance(), between ref and each of the lists,
+/// in a single walk through ref.
+/// \param  ref The list to compare the others to.
+/// \param  lists Array of nb_lists lists.
+/// \param  nb_lists Number of lists in lists.
+/// \param  data_size The size in bytes of one data object.
+/// \param  distances Array of nb_lists results, distances[j] is the distance
+/// between ref and lists[j].
+/// \return LINKEDLIST_OK, or an error status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_distance_many(linkedlist_t * const ref,
+                                             linkedlist_t * const lists[],
+                                             int const nb_lists,
+                                             size_t const data_size,
+                                             int distances[]);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Same as linkedlist_distance(), between all pairs of lists, e.g. to
+/// measure the diversity of a population.
+/// \param  lists Array of nb_lists lists.
+/// \param  nb_lists Number of lists in lists.
+/// \param  data_size The size in bytes of one data object.
+/// \param  distances Matrix of nb_lists * nb_lists results, in row order:
+/// distances[i * nb_lists + j] is the distance between lists[i] and lists[j].
+/// \return LINKEDLIST_OK, or an error status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_distance_all_pairs(linkedlist_t * const lists[],
+                                                  int const nb_lists,
+                                                  size_t const data_size,
+                                                  int distances[]);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Set the size of the data of list, for memory accounting. The copy
+/// functions set it to their data_size parameter. It is 0 for a new list, so
+/// that only its nodes are accounted for.
+/// \param  list The list to set the data size of.
+/// \param  data_size The size in bytes of one data object.
+//  ----------------------------------------------------------------------------
+void linkedlist_data_size_set(linkedlist_t * const list,
+                              size_t const data_size);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the memory used by the nodes and data of list, in constant time.
+/// The data are accounted for with the size set by linkedlist_data_size_set()
+/// or by the last copy to list. While list interns its data, only its nodes
+/// are: the data are accounted for once per entry of the table, in
+/// linkedlist_memory_total_get() only.
+/// \param  list The list to get the memory of.
+/// \return Memory in bytes.
+//  ----------------------------------------------------------------------------
+size_t linkedlist_memory_get(linkedlist_t * const list);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the memory used by the nodes and data of all existing lists,
+/// and by the data of intern tables.
+/// \return Memory in bytes.
+//  ----------------------------------------------------------------------------
+size_t linkedlist_memory_total_get(void);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Limit the memory that list may use, as given by
+/// linkedlist_memory_get(). Operations that would make the list grow above
+/// its budget (add, copy, cross...) return LINKEDLIST_OVER_BUDGET and leave
+/// the list untouched. Shrinking is always allowed.
+/// \param  list The list to limit.
+/// \param  budget Max memory in bytes, 0 for no limit (the default).
+//  ----------------------------------------------------------------------------
+void linkedlist_budget_set(linkedlist_t * const list, size_t const budget);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Create a group of lists sharing a memory budget, e.g. a
+/// population. Lists join it with linkedlist_group_set(). The lists of a
+/// group may be used from different threads. The budget is then checked by
+/// each list before it grows, so lists growing at the same time may together
+/// exceed it.
+/// \param  budget Max memory of all the lists in the group together, in bytes.
+/// 0 for no limit, for accounting only.
+/// \return Pointer to the new group.
+//  ----------------------------------------------------------------------------
+linkedlist_group_t *linkedlist_group_create(size_t const budget);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Destroy a group. All its lists must have left it or been destroyed.
+//  ----------------------------------------------------------------------------
+void linkedlist_group_destroy(linkedlist_group_t *group);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Move list to group, leaving its previous group if any. The memory
+/// of list is accounted for in its new group, even if it exceeds its budget.
+/// \param  list The list to move.
+/// \param  group The group to join, NULL to leave the current group.
+//  ----------------------------------------------------------------------------
+void linkedlist_group_set(linkedlist_t * const list,
+                          linkedlist_group_t * const group);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the memory used by the nodes and data of the lists of group.
+/// \return Memory in bytes.
+//  ----------------------------------------------------------------------------
+size_t linkedlist_group_memory_get(linkedlist_group_t * const group);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Create a table to intern data of data_size bytes. Lists using the
+/// table share one reference counted copy of equal data: copying a list costs
+/// new nodes but no new data, and equal data compare by pointer. See
+/// linkedlist_intern_set().
+/// \param  data_size The size of one data, the key is all its bytes.
+/// \return Pointer to the new table, NULL if out of memory.
+/// \attention  Lists of one table may be used from different threads, e.g. a
+/// population bred by workers: references are counted atomically and the
+/// table is locked for lookups. Each list must still be used from one thread
+/// at a time.
+//  ----------------------------------------------------------------------------
+linkedlist_intern_t *linkedlist_intern_create(size_t const data_size);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Destroy a table. All its lists must have left it or been
+/// destroyed, and all its data must have been released.
+//  ----------------------------------------------------------------------------
+void linkedlist_intern_destroy(linkedlist_intern_t *table);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Make list intern its data in table. The data already in list, and
+/// those later added or copied to it, are then shared with the other lists of
+/// table. Data added with linkedlist_add() are freed if equal data are already
+/// in the table, which invalidates the caller's pointer to them. Nodes keep
+/// their shared data when moved to other lists by linkedlist_cross(), concat
+/// or split, and release them when destroyed. NULL data are never shared. The
+/// memory of list and its budget then count its nodes only, see
+/// linkedlist_memory_get().
+/// \param  list The list. If its data size is 0, it takes that of table (see
+/// linkedlist_data_size_set()).
+/// \param  table The table, NULL to stop interning new data. Data already
+/// shared stay so.
+/// \return LINKEDLIST_OK, LINKEDLIST_ERR_MISMATCH if list has another data
+/// size than table, or another error status.
+/// \attention  Handles to the data of list are invalidated. Handles obtained
+/// later are to private copies, see linkedlist_data_handle_get(), and
+/// linkedlist_data_set() writes without copying twice.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_intern_set(linkedlist_t * const list,
+                                          linkedlist_intern_t * const table);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the number of distinct data in table.
+//  ----------------------------------------------------------------------------
+size_t linkedlist_intern_size_get(linkedlist_intern_t const * const table);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Create an empty delta, to be filled by linkedlist_diff() or
+/// linkedlist_delta_read().
+/// \return Pointer to the new delta, NULL if out of memory.
+//  ----------------------------------------------------------------------------
+linkedlist_delta_t *linkedlist_delta_create(void);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Destroy a delta.
+//  ----------------------------------------------------------------------------
+void linkedlist_delta_destroy(linkedlist_delta_t *delta);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Compute the edits turning from into to: the ranges of positions
+/// where their data differ, with a copy of the data of to, the data appended
+/// past the end of from, and the truncation to the size of to. The delta
+/// costs the size of what changed, not of the lists. Data are compared like
+/// linkedlist_compare() does.
+/// \param  delta The delta to fill, overwritten.
+/// \param  from The list before.
+/// \param  to The list after.
+/// \param  data_size The size of one data.
+/// \return LINKEDLIST_OK, or an error status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_diff(linkedlist_delta_t * const delta,
+                                    linkedlist_t * const from,
+                                    linkedlist_t * const to,
+                                    size_t const data_size);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Apply a delta to a list equal to its from list, which makes it
+/// equal to its to list. Data are written in place, or shared if list interns
+/// its data.
+/// \param  list The list to patch.
+/// \param  delta The delta to apply.
+/// \return LINKEDLIST_OK, LINKEDLIST_OVER_BUDGET, LINKEDLIST_ERR_MISMATCH if
+/// list does not have the size of the from list, has a data size (or an
+/// intern table) for other data than the delta, or cannot hold the to list
+/// (capacity of a circular list, or LINKEDLIST_MAX_SIZE), or another error
+/// status. On errors after the checks, list is partly patched.
+/// \attention  Only the size of list is checked, patching a list with other
+/// data gives a list matching to at the changed positions only.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_patch(linkedlist_t * const list,
+                                     linkedlist_delta_t const * const delta);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the number of data held by a delta, i.e. the number of
+/// positions changed or appended.
+//  ----------------------------------------------------------------------------
+int linkedlist_delta_size_get(linkedlist_delta_t const * const delta);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Encode a delta to a binary stream, e.g. a checkpoint file. The
+/// encoding is sequential and does not depend on the host byte order. Data are
+/// written as they are in memory.
+/// \param  delta The delta to write.
+/// \param  stream Stream opened for writing in binary mode.
+/// \return LINKEDLIST_OK, LINKEDLIST_ERR_IO if writing failed, or an error
+/// status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_delta_write(
+    linkedlist_delta_t const * const delta,
+    FILE * const stream);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Decode a delta written by linkedlist_delta_write(), leaving the
+/// stream after it so that several deltas can follow each other.
+/// \param  delta The delta to fill, overwritten.
+/// \param  stream Stream opened for reading in binary mode.
+/// \return LINKEDLIST_OK, LINKEDLIST_ERR_IO if reading failed or the data are
+/// malformed, e.g. data of more than 1 MiB each or 64 MiB in all, or an error
+/// status. The delta is left empty on errors.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_delta_read(linkedlist_delta_t * const delta,
+                                          FILE * const stream);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Keep an aggregate over the data of list, e.g. a sum or max, so that
+/// it can be queried over any range in O(log n). The values are kept with the
+/// nodes: pop, rotate, and the splices of cross, concat and split move them in
+/// O(log n). Nodes new to list (add, copy...), or coming from a list without
+/// an equal aggregate, are mapped lazily, by the next query.
+/// \param  list The list.
+/// \param  aggregate The aggregate to keep, NULL to drop the current one. The
+/// structure and identity are copied.
+/// \return LINKEDLIST_OK, or an error status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_aggregate_set(
+    linkedlist_t * const list,
+    linkedlist_aggregate_t const * const aggregate);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the aggregate of the data of list in the range [start, end).
+/// \param  list The list, with an aggregate set.
+/// \param  start First position, clamped to 0.
+/// \param  end One past the last position, clamped to the size of list. The
+/// aggregate of an empty range is the identity.
+/// \param  result Where to write the value, value_size bytes.
+/// \return LINKEDLIST_OK, or an error status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_aggregate_get(linkedlist_t * const list,
+                                             int const start,
+                                             int const end,
+                                             void * const result);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Tell the aggregate of list that the data at position was written
+/// through a handle. Costs O(log n).
+/// \param  list The list, with an aggregate set.
+/// \param  position Position of the data written, not taken modulo the size.
+/// \return LINKEDLIST_OK, or an error status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_aggregate_update(linkedlist_t * const list,
+                                                int const position);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the last error reported by a linkedlist function in the calling
+/// thread. Functions that succeed do not reset it.
+/// \return The last status that was not LINKEDLIST_OK, or LINKEDLIST_OK if
+/// none since the last call to linkedlist_last_error_clear().
+/// \attention  Always LINKEDLIST_OK when built with LINKEDLIST_NO_DIAGNOSTICS.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_last_error_get(void);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Reset the last error of the calling thread to LINKEDLIST_OK.
+//  ----------------------------------------------------------------------------
+void linkedlist_last_error_clear(void);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Install a function to be called on each error, e.g. to log it.
+/// There is none by default, errors are silent apart from their status.
+/// \param  hook The function to install, NULL to remove the current one.
+/// \attention  Not thread safe, install the hook before starting threads.
+//  ----------------------------------------------------------------------------
+void linkedlist_log_hook_set(linkedlist_log_hook_t const hook);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Log hook that prints errors on stderr, as the module used to.
+//  ----------------------------------------------------------------------------
+void linkedlist_log_stderr(linkedlist_status_t status, char const *func);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get a human readable description of status.
+//  ----------------------------------------------------------------------------
+char const *linkedlist_status_str(linkedlist_status_t const status);
+
 #endif // LINKEDLIST_H_INCLUDED
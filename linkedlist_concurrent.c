@@ -0,0 +1,241 @@
+/*----------------------------------------------------------------------------
+Copyright (c) 2013 Gauthier Fleutot Ostervall
+----------------------------------------------------------------------------*/
+#include "linkedlist_concurrent.h"
+
+#include "linkedlist.h"
+#include "linkedlist_error.h"
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+// The list is an intrusive multi-producer single-consumer queue: producers
+// swap themselves in as the tail, then link the previous tail to their node.
+// The consumer owns head, which always points to an already consumed node
+// (initially the stub). A node is freed only once its next is known, so no
+// producer can still be linking to it.
+typedef struct cnode_s {
+    void const *data;
+    struct cnode_s *next;
+} cnode_t;
+
+struct linkedlist_concurrent_s {
+    // Written by producers.
+    cnode_t *tail;
+    int size;
+    char padding[64];   // Keep the consumer's fields off the producers' line.
+    // Written by the consumer only.
+    cnode_t *head;
+    cnode_t stub;
+};
+
+//******************************************************************************
+// Module constants
+//******************************************************************************
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+static bool slot_reserve(linkedlist_concurrent_t * const list);
+static bool cnode_peek(linkedlist_concurrent_t * const list, void **data);
+static bool cnode_pop(linkedlist_concurrent_t * const list, void **data);
+
+//******************************************************************************
+// Function definitions
+//******************************************************************************
+//  ----------------------------------------------------------------------------
+/// \brief  Create a new empty list, head and tail on the stub node.
+//  ----------------------------------------------------------------------------
+linkedlist_concurrent_t *linkedlist_concurrent_create(void)
+{
+    linkedlist_concurrent_t *new_list_p = malloc(sizeof (*new_list_p));
+    if (new_list_p == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+        return NULL;
+    }
+    new_list_p->stub = (cnode_t) {
+        .data = NULL,
+        .next = NULL
+    };
+    new_list_p->head = &new_list_p->stub;
+    new_list_p->tail = &new_list_p->stub;
+    new_list_p->size = 0;
+    return new_list_p;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Pop and free all remaining data, then the list itself.
+//  ----------------------------------------------------------------------------
+void linkedlist_concurrent_destroy(linkedlist_concurrent_t *list)
+{
+    if (list == NULL) {
+        return;
+    }
+
+    void *data;
+    while (cnode_pop(list, &data)) {
+        free(data);
+    }
+    if (list->head != &list->stub) {
+        free(list->head);
+    }
+    free(list);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Reserve a slot in the size count first, so that the cap holds
+/// without a lock. Then swap the new node in as the tail (the exchange never
+/// has to retry, unlike a compare-and-swap loop on the tail), and link the
+/// previous tail to it.
+//  ----------------------------------------------------------------------------
+bool linkedlist_concurrent_add(linkedlist_concurrent_t * const list,
+                               void const * const data)
+{
+    if (list == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+        return false;
+    }
+
+    if (!slot_reserve(list)) {
+        // Max reached, which is not an error.
+        return false;
+    }
+
+    cnode_t *new_node_p = malloc(sizeof (cnode_t));
+    if (new_node_p == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);
+        __atomic_sub_fetch(&list->size, 1, __ATOMIC_RELEASE);
+        return false;
+    }
+    *new_node_p = (cnode_t) {
+        .data = data,
+        .next = NULL
+    };
+
+    cnode_t *prev = __atomic_exchange_n(&list->tail, new_node_p,
+                                        __ATOMIC_ACQ_REL);
+    // Until this store, the consumer sees the list as ending at prev.
+    __atomic_store_n(&prev->next, new_node_p, __ATOMIC_RELEASE);
+    return true;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Add the data at the head to dst, and pop them only once added, until
+/// the list looks empty. A producer caught between its exchange and its link
+/// ends the drain early, its data will come with the next drain.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_concurrent_drain(
+    linkedlist_concurrent_t * const list,
+    linkedlist_t * const dst,
+    int * const moved)
+{
+    if (moved != NULL) {
+        *moved = 0;
+    }
+    if (list == NULL || dst == NULL) {
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+    }
+
+    void *data;
+    while (cnode_peek(list, &data)) {
+        linkedlist_status_t const status = linkedlist_add(dst, data);
+        if (status != LINKEDLIST_OK) {
+            // The data stay in the list, for a later drain.
+            return status;
+        }
+        cnode_pop(list, &data);
+        if (moved != NULL) {
+            (*moved)++;
+        }
+    }
+    return LINKEDLIST_OK;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Read the reserved size count.
+//  ----------------------------------------------------------------------------
+int linkedlist_concurrent_size_get(linkedlist_concurrent_t * const list)
+{
+    if (list == NULL) {
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+        return 0;
+    }
+    return __atomic_load_n(&list->size, __ATOMIC_ACQUIRE);
+}
+
+
+//******************************************************************************
+// Internal functions
+//******************************************************************************
+//  ----------------------------------------------------------------------------
+/// \brief  Increment the size count, unless it already is at max.
+/// \param  list    The list to reserve a slot in.
+/// \return True if a slot was reserved.
+//  ----------------------------------------------------------------------------
+static bool slot_reserve(linkedlist_concurrent_t * const list)
+{
+    int size = __atomic_load_n(&list->size, __ATOMIC_RELAXED);
+    do {
+        if (size >= (int) LINKEDLIST_MAX_SIZE) {
+            return false;
+        }
+    } while (!__atomic_compare_exchange_n(&list->size, &size, size + 1,
+                                          true, __ATOMIC_ACQ_REL,
+                                          __ATOMIC_RELAXED));
+    return true;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Read the data of the node after head, without popping it. Consumer
+/// side only.
+/// \param  list    The list to peek into.
+/// \param  data    Where to write the data pointer.
+/// \return False if there was nothing (visible yet) to pop.
+//  ----------------------------------------------------------------------------
+static bool cnode_peek(linkedlist_concurrent_t * const list, void **data)
+{
+    cnode_t const * const next = __atomic_load_n(&list->head->next,
+                                                 __ATOMIC_ACQUIRE);
+    if (next == NULL) {
+        return false;
+    }
+    *data = (void *) next->data;
+    return true;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Take the data of the node after head, which becomes the new head.
+/// The old head is freed, unless it is the stub. Consumer side only.
+/// \param  list    The list to pop from.
+/// \param  data    Where to write the popped data pointer.
+/// \return False if there was nothing (visible yet) to pop.
+//  ----------------------------------------------------------------------------
+static bool cnode_pop(linkedlist_concurrent_t * const list, void **data)
+{
+    cnode_t *head = list->head;
+    cnode_t *next = __atomic_load_n(&head->next, __ATOMIC_ACQUIRE);
+    if (next == NULL) {
+        return false;
+    }
+
+    *data = (void *) next->data;
+    next->data = NULL;
+    list->head = next;
+    if (head != &list->stub) {
+        free(head);
+    }
+    __atomic_sub_fetch(&list->size, 1, __ATOMIC_RELEASE);
+    return true;
+}
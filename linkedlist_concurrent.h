@@ -0,0 +1,72 @@
+/*----------------------------------------------------------------------------
+Copyright (c) 2013 Gauthier Fleutot Ostervall
+----------------------------------------------------------------------------*/
+
+#ifndef LINKEDLIST_CONCURRENT_H_INCLUDED
+#define LINKEDLIST_CONCURRENT_H_INCLUDED
+
+#include "linkedlist.h"
+
+#include <stdbool.h>
+
+// List that any number of threads may add to at the same time, without
+// locking. Only one thread at a time may drain it. The number of elements
+// waiting in the list is capped at LINKEDLIST_MAX_SIZE, like linkedlist_t.
+// Do not create your own linkedlist_concurrent_t variables, use the function
+// linkedlist_concurrent_create().
+typedef struct linkedlist_concurrent_s linkedlist_concurrent_t;
+
+//  ----------------------------------------------------------------------------
+/// \brief  Create a new empty concurrent list.
+/// \return Pointer to the new list.
+//  ----------------------------------------------------------------------------
+linkedlist_concurrent_t *linkedlist_concurrent_create(void);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Destroy the list, its remaining nodes and their data. No other
+/// thread may use the list anymore.
+/// \param  list The list to destroy.
+//  ----------------------------------------------------------------------------
+void linkedlist_concurrent_destroy(linkedlist_concurrent_t *list);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Link a new node at the end of the list. Lock-free, may be called
+/// from any number of threads concurrently.
+/// \param  list Destination list.
+/// \param  data Pointer to the data content of the new node. Memory must be
+/// dynamically allocated.
+/// \return True if the data was added. False if the list already held
+/// LINKEDLIST_MAX_SIZE elements (or memory ran out), in which case the data
+/// is still owned by the caller.
+//  ----------------------------------------------------------------------------
+bool linkedlist_concurrent_add(linkedlist_concurrent_t * const list,
+                               void const * const data);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Move the data added so far to the end of dst, in the order they
+/// were added. Only one thread at a time may drain a given list, but
+/// producers may keep adding meanwhile. Draining stops early if dst cannot
+/// take more data, which then stay in the list.
+/// \param  list The list to drain.
+/// \param  dst The list to move the data to.
+/// \param  moved Where to write the number of data moved to dst. May be NULL.
+/// \return LINKEDLIST_OK once the list is empty, or the status of the
+/// linkedlist_add() that stopped the drain: LINKEDLIST_FULL,
+/// LINKEDLIST_OVER_BUDGET or an error status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_concurrent_drain(
+    linkedlist_concurrent_t * const list,
+    linkedlist_t * const dst,
+    int * const moved);
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the number of elements added but not drained yet. Only a
+/// snapshot if producers are running.
+//  ----------------------------------------------------------------------------
+int linkedlist_concurrent_size_get(linkedlist_concurrent_t * const list);
+
+#endif // LINKEDLIST_CONCURRENT_H_INCLUDED
@@ -0,0 +1,46 @@
+/*----------------------------------------------------------------------------
+Copyright (c) 2013 Gauthier Fleutot Ostervall
+----------------------------------------------------------------------------*/
+
+// Error reporting shared by the linkedlist modules. Not part of the API, only
+// include from the modules' .c files, and from linkedlist_typed.h whose
+// functions are compiled in the caller's.
+
+#ifndef LINKEDLIST_ERROR_H_INCLUDED
+#define LINKEDLIST_ERROR_H_INCLUDED
+
+#include "linkedlist.h"
+
+// Report status as the calling function's error, and evaluate to status, so
+// that it can be used as: return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);
+// Building with LINKEDLIST_NO_DIAGNOSTICS removes the reporting altogether,
+// only the returned status codes remain.
+#ifdef LINKEDLIST_NO_DIAGNOSTICS
+#define LINKEDLIST_ERROR(status) linkedlist_error_silent(status)
+#else
+#define LINKEDLIST_ERROR(status) linkedlist_error_report((status), __func__)
+#endif
+
+//  ----------------------------------------------------------------------------
+/// \brief  Save status as the last error of the calling thread, and pass it to
+/// the log hook if one is installed. Use LINKEDLIST_ERROR() instead.
+/// \param  status The error to report.
+/// \param  func Name of the function the error happened in.
+/// \return status.
+//  ----------------------------------------------------------------------------
+linkedlist_status_t linkedlist_error_report(linkedlist_status_t const status,
+                                            char const * const func);
+
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Pass status through. Used by LINKEDLIST_ERROR() when diagnostics
+/// are compiled out, so that unused results do not warn.
+//  ----------------------------------------------------------------------------
+static inline linkedlist_status_t linkedlist_error_silent(
+    linkedlist_status_t const status)
+{
+    return status;
+}
+
+#endif // LINKEDLIST_ERROR_H_INCLUDED
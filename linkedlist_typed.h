@@ -0,0 +1,345 @@
+/*----------------------------------------------------------------------------
+Copyright (c) 2013 Gauthier Fleutot Ostervall
+----------------------------------------------------------------------------*/
+
+// Type specialized linked lists. LINKEDLIST_DEFINE(name, T) defines the list
+// type name_t and its functions name_*(), storing payloads of type T inline in
+// the nodes. Since the payload size is known at compile time, copies and
+// comparisons become plain sized moves and compares that the compiler can
+// inline and vectorize, instead of memcpy()/memcmp() calls on a runtime size.
+//
+// The functions follow the generic linkedlist_*() ones, with T const * in
+// place of void const * and no data_size parameter. The typed lists own their
+// payloads: adding copies the value, so no dynamic allocation is needed from
+// the caller. name_to_linkedlist() and name_from_linkedlist() convert from and
+// to the generic linkedlist_t, so both interfaces can be mixed.
+//
+// Example, at file scope:
+//     typedef struct { int a; int b; } gene_t;
+//     LINKEDLIST_DEFINE(genome, gene_t)
+// gives genome_t, genome_create(), genome_add(), ...
+//
+// T is compared with memcmp(), like in the generic list. Padding bytes in T
+// take part in the comparison.
+
+#ifndef LINKEDLIST_TYPED_H_INCLUDED
+#define LINKEDLIST_TYPED_H_INCLUDED
+
+#include "linkedlist.h"
+#include "linkedlist_error.h"
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define LINKEDLIST_DEFINE(name, T)                                            \
+                                                                              \
+typedef struct name##_node_s {                                                \
+    struct name##_node_s *next;                                               \
+    T data;                                                                   \
+} name##_node_t;                                                              \
+                                                                              \
+typedef struct {                                                              \
+    int size;                                                                 \
+    name##_node_t *head;                                                      \
+    name##_node_t *tail;                                                      \
+} name##_t;                                                                   \
+                                                                              \
+/* Create a new empty list. NULL if out of memory. */                         \
+static inline name##_t *name##_create(void)                                   \
+{                                                                             \
+    name##_t *list = malloc(sizeof (name##_t));                               \
+    if (list == NULL) {                                                       \
+        LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);                           \
+        return NULL;                                                          \
+    }                                                                         \
+    *list = (name##_t) { .size = 0, .head = NULL, .tail = NULL };             \
+    return list;                                                              \
+}                                                                             \
+                                                                              \
+/* Free all nodes, keep the list object. */                                   \
+static inline void name##_clear(name##_t * const list)                        \
+{                                                                             \
+    name##_node_t *walker = list->head;                                       \
+    while (walker != NULL) {                                                  \
+        name##_node_t *next = walker->next;                                   \
+        free(walker);                                                         \
+        walker = next;                                                        \
+    }                                                                         \
+    *list = (name##_t) { .size = 0, .head = NULL, .tail = NULL };             \
+}                                                                             \
+                                                                              \
+/* Destroy the list, its nodes and payloads. */                               \
+static inline void name##_destroy(name##_t *list)                             \
+{                                                                             \
+    if (list != NULL) {                                                       \
+        name##_clear(list);                                                   \
+        free(list);                                                           \
+    }                                                                         \
+}                                                                             \
+                                                                              \
+/* Copy *data into a new node at the end of dst. */                           \
+static inline linkedlist_status_t name##_add(name##_t * const dst,            \
+                                             T const * const data)            \
+{                                                                             \
+    if (dst == NULL || data == NULL) {                                        \
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);                         \
+    }                                                                         \
+    if (dst->size >= (int) LINKEDLIST_MAX_SIZE) {                             \
+        return LINKEDLIST_FULL;                                               \
+    }                                                                         \
+    name##_node_t *new_node_p = malloc(sizeof (name##_node_t));               \
+    if (new_node_p == NULL) {                                                 \
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);                    \
+    }                                                                         \
+    new_node_p->next = NULL;                                                  \
+    new_node_p->data = *data;                                                 \
+    if (dst->head == NULL) {                                                  \
+        dst->head = new_node_p;                                               \
+    } else {                                                                  \
+        dst->tail->next = new_node_p;                                         \
+    }                                                                         \
+    dst->tail = new_node_p;                                                   \
+    dst->size++;                                                              \
+    return LINKEDLIST_OK;                                                     \
+}                                                                             \
+                                                                              \
+static inline int name##_size_get(name##_t const * const list)                \
+{                                                                             \
+    return (list != NULL) ? list->size : 0;                                   \
+}                                                                             \
+                                                                              \
+/* Node at position reduced modulo the size, NULL if empty. */                \
+static inline name##_node_t *name##_node_get(name##_t const * const list,     \
+                                             long const position)             \
+{                                                                             \
+    if (list->size == 0) {                                                    \
+        return NULL;                                                          \
+    }                                                                         \
+    long steps = position % list->size;                                       \
+    if (steps < 0) {                                                          \
+        steps += list->size;                                                  \
+    }                                                                         \
+    if (steps == list->size - 1) {                                            \
+        return list->tail;                                                    \
+    }                                                                         \
+    name##_node_t *walker = list->head;                                       \
+    for (long i = 0; i < steps; i++) {                                        \
+        walker = walker->next;                                                \
+    }                                                                         \
+    return walker;                                                            \
+}                                                                             \
+                                                                              \
+/* Same as linkedlist_data_handle_get(). */                                   \
+static inline T *name##_data_handle_get(name##_t const * const list,          \
+                                        unsigned int const position)          \
+{                                                                             \
+    name##_node_t *node = name##_node_get(list, position);                    \
+    return (node != NULL) ? &node->data : NULL;                               \
+}                                                                             \
+                                                                              \
+static inline linkedlist_status_t name##_run_for_all(                         \
+    name##_t const * const list,                                              \
+    void (*callback)(T const * const data))                                   \
+{                                                                             \
+    if (list == NULL) {                                                       \
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);                         \
+    }                                                                         \
+    for (name##_node_t *walker = list->head; walker != NULL;                  \
+         walker = walker->next) {                                             \
+        callback(&walker->data);                                              \
+    }                                                                         \
+    return LINKEDLIST_OK;                                                     \
+}                                                                             \
+                                                                              \
+/* Same as linkedlist_copy(). Nodes already in dst are reused. */             \
+static inline linkedlist_status_t name##_copy(name##_t * const dst,           \
+                                              name##_t const * const src)     \
+{                                                                             \
+    if (dst == NULL || src == NULL) {                                         \
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);                         \
+    }                                                                         \
+    name##_node_t *from = src->head;                                          \
+    name##_node_t *to = dst->head;                                            \
+    name##_node_t *last = NULL;                                               \
+    int copied = 0;                                                           \
+    while (from != NULL && to != NULL) {                                      \
+        to->data = from->data;                                                \
+        last = to;                                                            \
+        copied++;                                                             \
+        from = from->next;                                                    \
+        to = to->next;                                                        \
+    }                                                                         \
+    /* Drop what dst has in excess, then add what it lacks. */                \
+    if (last != NULL) {                                                       \
+        last->next = NULL;                                                    \
+    } else {                                                                  \
+        dst->head = NULL;                                                     \
+    }                                                                         \
+    dst->tail = last;                                                         \
+    dst->size = copied;                                                       \
+    while (to != NULL) {                                                      \
+        name##_node_t *next = to->next;                                       \
+        free(to);                                                             \
+        to = next;                                                            \
+    }                                                                         \
+    for (; from != NULL; from = from->next) {                                 \
+        linkedlist_status_t const status = name##_add(dst, &from->data);      \
+        if (status != LINKEDLIST_OK) {                                        \
+            return status;                                                    \
+        }                                                                     \
+    }                                                                         \
+    return LINKEDLIST_OK;                                                     \
+}                                                                             \
+                                                                              \
+/* Same as linkedlist_compare(). */                                           \
+static inline bool name##_compare(name##_t const * const list_a,              \
+                                  name##_t const * const list_b)              \
+{                                                                             \
+    if (list_a->size != list_b->size) {                                       \
+        return false;                                                         \
+    }                                                                         \
+    name##_node_t *walker_a = list_a->head;                                   \
+    name##_node_t *walker_b = list_b->head;                                   \
+    while (walker_a != NULL) {                                                \
+        if (memcmp(&walker_a->data, &walker_b->data, sizeof (T)) != 0) {      \
+            return false;                                                     \
+        }                                                                     \
+        walker_a = walker_a->next;                                            \
+        walker_b = walker_b->next;                                            \
+    }                                                                         \
+    return true;                                                              \
+}                                                                             \
+                                                                              \
+/* Same as linkedlist_distance(), returning the distance. */                 \
+static inline int name##_distance(name##_t const * const list_a,              \
+                                  name##_t const * const list_b)              \
+{                                                                             \
+    int distance = abs(list_a->size - list_b->size);                          \
+    name##_node_t *walker_a = list_a->head;                                   \
+    name##_node_t *walker_b = list_b->head;                                   \
+    while (walker_a != NULL && walker_b != NULL) {                            \
+        distance += memcmp(&walker_a->data, &walker_b->data, sizeof (T)) != 0;\
+        walker_a = walker_a->next;                                            \
+        walker_b = walker_b->next;                                            \
+    }                                                                         \
+    return distance;                                                          \
+}                                                                             \
+                                                                              \
+/* Truncate list to limit nodes if it is longer. */                           \
+static inline void name##_length_limit(name##_t * const list,                 \
+                                       int const limit)                       \
+{                                                                             \
+    if (list->size <= limit) {                                                \
+        return;                                                               \
+    }                                                                         \
+    name##_node_t *rest;                                                      \
+    if (limit == 0) {                                                         \
+        rest = list->head;                                                    \
+        list->head = NULL;                                                    \
+        list->tail = NULL;                                                    \
+    } else {                                                                  \
+        list->tail = name##_node_get(list, limit - 1);                        \
+        rest = list->tail->next;                                              \
+        list->tail->next = NULL;                                              \
+    }                                                                         \
+    while (rest != NULL) {                                                    \
+        name##_node_t *next = rest->next;                                     \
+        free(rest);                                                           \
+        rest = next;                                                          \
+    }                                                                         \
+    list->size = limit;                                                       \
+}                                                                             \
+                                                                              \
+/* Same as linkedlist_cross(). */                                             \
+static inline linkedlist_status_t name##_cross(name##_t * const list_a,       \
+                                               int const pos_a,               \
+                                               name##_t * const list_b,       \
+                                               int const pos_b)               \
+{                                                                             \
+    if (list_a == NULL || list_b == NULL) {                                   \
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);                         \
+    }                                                                         \
+    name##_node_t *prev_a =                                                   \
+        (pos_a > 0) ? name##_node_get(list_a, pos_a - 1) : NULL;              \
+    name##_node_t *prev_b =                                                   \
+        (pos_b > 0) ? name##_node_get(list_b, pos_b - 1) : NULL;              \
+    name##_node_t *part_a = (prev_a != NULL) ? prev_a->next : list_a->head;   \
+    name##_node_t *part_b = (prev_b != NULL) ? prev_b->next : list_b->head;   \
+    name##_node_t *old_tail_a = list_a->tail;                                 \
+    name##_node_t *old_tail_b = list_b->tail;                                 \
+    if (prev_a == NULL) {                                                     \
+        list_a->head = part_b;                                                \
+    } else {                                                                  \
+        prev_a->next = part_b;                                                \
+    }                                                                         \
+    if (prev_b == NULL) {                                                     \
+        list_b->head = part_a;                                                \
+    } else {                                                                  \
+        prev_b->next = part_a;                                                \
+    }                                                                         \
+    list_a->tail = (part_b != NULL) ? old_tail_b : prev_a;                    \
+    list_b->tail = (part_a != NULL) ? old_tail_a : prev_b;                    \
+    int const old_size_a = list_a->size;                                      \
+    list_a->size = pos_a + list_b->size - pos_b;                              \
+    list_b->size = pos_b + old_size_a - pos_a;                                \
+    name##_length_limit(list_a, LINKEDLIST_MAX_SIZE);                         \
+    name##_length_limit(list_b, LINKEDLIST_MAX_SIZE);                         \
+    return LINKEDLIST_OK;                                                     \
+}                                                                             \
+                                                                              \
+/* Append a copy of each payload of src to the generic list dst. The       */ \
+/* copies are allocated one by one, as linkedlist_t expects.               */ \
+static inline linkedlist_status_t name##_to_linkedlist(                       \
+    linkedlist_t * const dst,                                                 \
+    name##_t const * const src)                                               \
+{                                                                             \
+    if (dst == NULL || src == NULL) {                                         \
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);                         \
+    }                                                                         \
+    for (name##_node_t *walker = src->head; walker != NULL;                   \
+         walker = walker->next) {                                             \
+        T *data = malloc(sizeof (T));                                         \
+        if (data == NULL) {                                                   \
+            return LINKEDLIST_ERROR(LINKEDLIST_ERR_NO_MEMORY);                \
+        }                                                                     \
+        *data = walker->data;                                                 \
+        linkedlist_status_t const status = linkedlist_add(dst, data);         \
+        if (status != LINKEDLIST_OK) {                                        \
+            free(data);                                                       \
+            return status;                                                    \
+        }                                                                     \
+    }                                                                         \
+    return LINKEDLIST_OK;                                                     \
+}                                                                             \
+                                                                              \
+/* Context of name##_from_linkedlist() through linkedlist_fold().          */ \
+typedef struct {                                                              \
+    name##_t *dst;                                                            \
+    linkedlist_status_t status;                                               \
+} name##_fold_context_t;                                                      \
+                                                                              \
+static inline bool name##_fold_add(void const * const data,                   \
+                                   void * const context)                      \
+{                                                                             \
+    name##_fold_context_t * const fold = context;                             \
+    fold->status = name##_add(fold->dst, data);                               \
+    return fold->status == LINKEDLIST_OK;                                     \
+}                                                                             \
+                                                                              \
+/* Append a copy of each payload of the generic list src to dst, stopping  */ \
+/* at the first failure. src is left untouched.                            */ \
+static inline linkedlist_status_t name##_from_linkedlist(                     \
+    name##_t * const dst,                                                     \
+    linkedlist_t * const src)                                                 \
+{                                                                             \
+    if (dst == NULL || src == NULL) {                                         \
+        return LINKEDLIST_ERROR(LINKEDLIST_ERR_NULL);                         \
+    }                                                                         \
+    name##_fold_context_t fold = { .dst = dst, .status = LINKEDLIST_OK };     \
+    linkedlist_fold(src, name##_fold_add, &fold);                             \
+    return fold.status;                                                       \
+}
+
+#endif // LINKEDLIST_TYPED_H_INCLUDED
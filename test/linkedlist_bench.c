@@ -0,0 +1,325 @@
+/*----------------------------------------------------------------------------
+Copyright (c) 2013 Gauthier Fleutot Ostervall
+----------------------------------------------------------------------------*/
+#define _POSIX_C_SOURCE 200112L
+
+// Modules under benchmark. The list module is included rather than linked, to
+// time its static comparison kernel payload_differs() against memcmp().
+#include "../linkedlist.c"
+#include "../linkedlist_concurrent.h"
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+//******************************************************************************
+// Module macros
+//******************************************************************************
+// Number of elements in array x.
+#define NB_ELEMENTS(x) (sizeof (x) / sizeof (x[0]))
+
+//******************************************************************************
+// Module constants
+//******************************************************************************
+// Each round fills a list up to max, then drains it.
+static const int nb_rounds = 200;
+static const int producer_counts[] = {1, 2, 4, 8, 16, 32, 64};
+// Population for the distance benchmark: mutated copies of one genome.
+enum { nb_genomes = 64, genome_size = 1000, gene_size = 64 };
+static const int nb_mutations = 20;
+
+//******************************************************************************
+// Module variables
+//******************************************************************************
+static linkedlist_concurrent_t *concurrent_list;
+static linkedlist_t *locked_list;
+static pthread_mutex_t locked_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+// Producers are started once, the barriers delimit the rounds.
+static pthread_barrier_t round_start;
+static pthread_barrier_t round_end;
+
+
+//******************************************************************************
+// Function prototypes
+//******************************************************************************
+// Helper functions.
+static double seconds_now(void);
+static void *concurrent_producer(void *arg);
+static void *locked_producer(void *arg);
+static double producers_run(int const nb_producers,
+                            void *(*producer)(void *),
+                            linkedlist_t * const result);
+static void list_empty(linkedlist_t * const list);
+
+// Benchmark functions.
+static void bench_concurrent_add(void);
+static void bench_distance(void);
+
+
+//******************************************************************************
+// Function definitions
+//******************************************************************************
+int main(void)
+{
+    bench_concurrent_add();
+    bench_distance();
+    return 0;
+}
+
+
+//******************************************************************************
+// Internal functions
+//******************************************************************************
+//  ----------------------------------------------------------------------------
+/// \brief  Compare the lock-free add with linkedlist_add wrapped in a mutex,
+/// for a growing number of producer threads.
+//  ----------------------------------------------------------------------------
+static void bench_concurrent_add(void)
+{
+    printf("%s: %d rounds of %u adds.\n", __func__, nb_rounds,
+           LINKEDLIST_MAX_SIZE);
+    printf("%10s %16s %16s\n", "producers", "lock-free add/s", "mutex add/s");
+
+    concurrent_list = linkedlist_concurrent_create();
+    locked_list = linkedlist_create();
+    linkedlist_t *result = linkedlist_create();
+
+    for (unsigned int i = 0; i < NB_ELEMENTS(producer_counts); i++) {
+        double const adds = (double) nb_rounds * LINKEDLIST_MAX_SIZE;
+        double const t_concurrent = producers_run(producer_counts[i],
+                                                  concurrent_producer,
+                                                  result);
+        double const t_locked = producers_run(producer_counts[i],
+                                              locked_producer,
+                                              result);
+        printf("%10d %16.0f %16.0f\n", producer_counts[i],
+               adds / t_concurrent, adds / t_locked);
+    }
+
+    linkedlist_destroy(result);
+    linkedlist_destroy(locked_list);
+    linkedlist_concurrent_destroy(concurrent_list);
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Measure the diversity of a population, with all-pairs distances
+/// against one linkedlist_distance() call per pair of the same upper triangle.
+/// Then compare the genes of the same pairs with payload_differs(), as
+/// compiled (build with -mavx2 for AVX2), and with memcmp() as its scalar
+/// fallback.
+//  ----------------------------------------------------------------------------
+static void bench_distance(void)
+{
+    printf("%s: %d genomes of %d genes of %d bytes.\n", __func__,
+           nb_genomes, genome_size, gene_size);
+
+    linkedlist_t *genomes[nb_genomes];
+    static unsigned char *genes[nb_genomes][genome_size];
+    for (int i = 0; i < nb_genomes; i++) {
+        genomes[i] = linkedlist_create();
+        for (int j = 0; j < genome_size; j++) {
+            unsigned char *gene = malloc(gene_size);
+            memset(gene, j & 0xFF, gene_size);
+            linkedlist_add(genomes[i], gene);
+            genes[i][j] = gene;
+        }
+        for (int m = 0; m < nb_mutations; m++) {
+            unsigned char *gene = genes[i][rand() % genome_size];
+            gene[rand() % gene_size] ^= 1;
+        }
+    }
+
+    static int distances[nb_genomes * nb_genomes];
+    const int repeat = 20;
+    double const pairs = (double) repeat * nb_genomes * (nb_genomes - 1) / 2;
+
+    double start = seconds_now();
+    for (int r = 0; r < repeat; r++) {
+        linkedlist_distance_all_pairs(genomes, nb_genomes, gene_size,
+                                      distances);
+    }
+    double const t_all_pairs = seconds_now() - start;
+
+    start = seconds_now();
+    for (int r = 0; r < repeat; r++) {
+        for (int i = 0; i < nb_genomes; i++) {
+            for (int j = i + 1; j < nb_genomes; j++) {
+                linkedlist_distance(genomes[i], genomes[j], gene_size,
+                                    &distances[i * nb_genomes + j]);
+            }
+        }
+    }
+    double const t_pairwise = seconds_now() - start;
+
+    printf("%16s %16.0f pairs/s\n", "all pairs", pairs / t_all_pairs);
+    printf("%16s %16.0f pairs/s\n", "pair by pair", pairs / t_pairwise);
+
+    // Same comparisons without the lists, one kernel at a time. The counts
+    // keep the comparisons from being optimized away, and must agree.
+    long differing_kernel = 0;
+    start = seconds_now();
+    for (int r = 0; r < repeat; r++) {
+        for (int i = 0; i < nb_genomes; i++) {
+            for (int j = i + 1; j < nb_genomes; j++) {
+                for (int k = 0; k < genome_size; k++) {
+                    differing_kernel += payload_differs(genes[i][k],
+                                                        genes[j][k],
+                                                        gene_size);
+                }
+            }
+        }
+    }
+    double const t_kernel = seconds_now() - start;
+
+    long differing_memcmp = 0;
+    start = seconds_now();
+    for (int r = 0; r < repeat; r++) {
+        for (int i = 0; i < nb_genomes; i++) {
+            for (int j = i + 1; j < nb_genomes; j++) {
+                for (int k = 0; k < genome_size; k++) {
+                    differing_memcmp += memcmp(genes[i][k], genes[j][k],
+                                               gene_size) != 0;
+                }
+            }
+        }
+    }
+    double const t_memcmp = seconds_now() - start;
+
+    printf("%16s %16.0f pairs/s\n", "payload_differs", pairs / t_kernel);
+    printf("%16s %16.0f pairs/s\n", "memcmp", pairs / t_memcmp);
+    if (differing_kernel != differing_memcmp) {
+        printf("kernels disagree: %ld and %ld differing genes.\n",
+               differing_kernel, differing_memcmp);
+    }
+
+    for (int i = 0; i < nb_genomes; i++) {
+        linkedlist_destroy(genomes[i]);
+    }
+}
+
+
+//------------------------------------------------------------------------------
+// Helper functions
+//------------------------------------------------------------------------------
+//  ----------------------------------------------------------------------------
+/// \brief  Get a monotonic time in seconds.
+//  ----------------------------------------------------------------------------
+static double seconds_now(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Add to the shared concurrent list until it is full.
+/// \param  arg Unused.
+//  ----------------------------------------------------------------------------
+static void *concurrent_producer(void *arg)
+{
+    (void) arg;
+    for (int round = 0; round < nb_rounds; round++) {
+        pthread_barrier_wait(&round_start);
+        for (;;) {
+            int *data = malloc(sizeof (int));
+            *data = 1;
+            if (!linkedlist_concurrent_add(concurrent_list, data)) {
+                free(data);
+                break;
+            }
+        }
+        pthread_barrier_wait(&round_end);
+    }
+    return NULL;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Add to the shared plain list, under a global mutex, until it is
+/// full.
+/// \param  arg Unused.
+//  ----------------------------------------------------------------------------
+static void *locked_producer(void *arg)
+{
+    (void) arg;
+    for (int round = 0; round < nb_rounds; round++) {
+        pthread_barrier_wait(&round_start);
+        bool full = false;
+        while (!full) {
+            int *data = malloc(sizeof (int));
+            *data = 1;
+            pthread_mutex_lock(&locked_list_mutex);
+            full = linkedlist_size_get(locked_list) >= LINKEDLIST_MAX_SIZE;
+            if (!full) {
+                linkedlist_add(locked_list, data);
+            }
+            pthread_mutex_unlock(&locked_list_mutex);
+            if (full) {
+                free(data);
+            }
+        }
+        pthread_barrier_wait(&round_end);
+    }
+    return NULL;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Start nb_producers threads that fill a shared list in rounds, and
+/// empty it between rounds (not timed).
+/// \param  nb_producers    Number of producer threads.
+/// \param  producer        Thread function.
+/// \param  result          Scratch list to drain into.
+/// \return Time spent in the producers, in seconds.
+//  ----------------------------------------------------------------------------
+static double producers_run(int const nb_producers,
+                            void *(*producer)(void *),
+                            linkedlist_t * const result)
+{
+    pthread_t threads[nb_producers];
+    double elapsed = 0.0;
+
+    pthread_barrier_init(&round_start, NULL, nb_producers + 1);
+    pthread_barrier_init(&round_end, NULL, nb_producers + 1);
+    for (int i = 0; i < nb_producers; i++) {
+        pthread_create(&threads[i], NULL, producer, NULL);
+    }
+
+    for (int round = 0; round < nb_rounds; round++) {
+        double const start = seconds_now();
+        pthread_barrier_wait(&round_start);
+        pthread_barrier_wait(&round_end);
+        elapsed += seconds_now() - start;
+
+        // Empty the lists.
+        linkedlist_concurrent_drain(concurrent_list, result, NULL);
+        list_empty(result);
+        list_empty(locked_list);
+    }
+
+    for (int i = 0; i < nb_producers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    pthread_barrier_destroy(&round_start);
+    pthread_barrier_destroy(&round_end);
+    return elapsed;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Pop and free all data of a list.
+/// \param  list    The list to empty.
+//  ----------------------------------------------------------------------------
+static void list_empty(linkedlist_t * const list)
+{
+    void *data;
+    while ((data = linkedlist_pop_front(list)) != NULL) {
+        free(data);
+    }
+}
@@ -2,14 +2,18 @@
 Copyright (c) 2013 Gauthier Fleutot Ostervall
 ----------------------------------------------------------------------------*/
 
-// Module under test.
+// Modules under test.
 #include "../linkedlist.h"
+#include "../linkedlist_concurrent.h"
+#include "../linkedlist_typed.h"
 
 #include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <malloc.h>
+#include <pthread.h>
+#include <string.h>
 
 //******************************************************************************
 // Module macros
@@ -26,6 +30,34 @@ Copyright (c) 2013 Gauthier Fleutot Ostervall
     } while (0)
 
 
+// Type specialized list under test.
+typedef struct {
+    int a;
+    int b;
+} gene_t;
+
+LINKEDLIST_DEFINE(genome, gene_t)
+
+// Context of int_collect().
+typedef struct {
+    int values[20];
+    int nb;
+    int max;    // Stop after max values.
+} int_array_t;
+
+// Context of intern_breeder().
+typedef struct {
+    linkedlist_t *parent;
+    linkedlist_intern_t *table;
+} breeding_t;
+
+// Context of int_equals(), counting the data visited.
+typedef struct {
+    int value;
+    int visited;
+} int_search_t;
+
+
 //******************************************************************************
 // Module constants
 //******************************************************************************
@@ -35,6 +67,9 @@ Copyright (c) 2013 Gauthier Fleutot Ostervall
 //******************************************************************************
 static int read_array[20];
 static unsigned int read_array_current_index;
+static linkedlist_status_t hooked_status;
+static char const *hooked_func;
+static unsigned int map_calls;   // Calls to int_map().
 
 
 //******************************************************************************
@@ -50,6 +85,20 @@ static void list_read_to_array(void const * const a);
 static bool int_arrays_equal(int const * const a,
                              int const * const b,
                              const int size);
+static void *concurrent_producer(void *list);
+static void *intern_breeder(void *breeding);
+static void *group_worker(void *group);
+static void log_hook(linkedlist_status_t status, char const *func);
+static void int_map(void const * const data, void * const value);
+static void int_sum(void const * const a, void const * const b,
+                    void * const result);
+static void int_max(void const * const a, void const * const b,
+                    void * const result);
+static int list_sum(linkedlist_t * const list, int const start,
+                    int const end);
+static bool int_collect(void const * const data, void * const context);
+static bool int_equals(void const * const data, void * const context);
+static bool int_positive(void const * const data, void * const context);
 
 // Test functions.
 static void test_linkedlist_init(void);
@@ -62,6 +111,24 @@ static void test_linkedlist_cross(void);
 static void test_linkedlist_cross_at_0(void);
 static void test_linkedlist_data_handle_get(void);
 static void test_linkedlist_cross_long(void);
+static void test_linkedlist_cross_pos_b_0(void);
+static void test_linkedlist_circular(void);
+static void test_linkedlist_pop_front(void);
+static void test_linkedlist_rotate(void);
+static void test_linkedlist_view(void);
+static void test_linkedlist_concurrent(void);
+static void test_linkedlist_status(void);
+static void test_linkedlist_typed(void);
+static void test_linkedlist_distance(void);
+static void test_linkedlist_copy_many(void);
+static void test_linkedlist_memory(void);
+static void test_linkedlist_group_threads(void);
+static void test_linkedlist_concat_split(void);
+static void test_linkedlist_aggregate(void);
+static void test_linkedlist_fold(void);
+static void test_linkedlist_intern(void);
+static void test_linkedlist_intern_threads(void);
+static void test_linkedlist_delta(void);
 
 
 //******************************************************************************
@@ -78,7 +145,25 @@ int main(void)
     test_linkedlist_cross();
     test_linkedlist_cross_at_0();
     test_linkedlist_cross_long();
+    test_linkedlist_cross_pos_b_0();
     test_linkedlist_data_handle_get();
+    test_linkedlist_circular();
+    test_linkedlist_pop_front();
+    test_linkedlist_rotate();
+    test_linkedlist_view();
+    test_linkedlist_concurrent();
+    test_linkedlist_status();
+    test_linkedlist_typed();
+    test_linkedlist_distance();
+    test_linkedlist_copy_many();
+    test_linkedlist_memory();
+    test_linkedlist_group_threads();
+    test_linkedlist_concat_split();
+    test_linkedlist_aggregate();
+    test_linkedlist_fold();
+    test_linkedlist_intern();
+    test_linkedlist_intern_threads();
+    test_linkedlist_delta();
     printf("All tests passed.\n");
 }
 
@@ -349,11 +434,1153 @@ static void test_linkedlist_data_handle_get(void)
     assert(result_ptr != NULL);
     assert(*result_ptr == data[other_pos]);
 
+    // Many laps cost no more than one.
+    result_ptr = (int *) linkedlist_data_handle_get(
+        list,
+        other_pos + 1000000 * NB_ELEMENTS(data)
+        );
+
+    assert(result_ptr != NULL);
+    assert(*result_ptr == data[other_pos]);
+
+    linkedlist_destroy(list);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_cross_pos_b_0(void)
+{
+    TEST_START_PRINT();
+    const int data_a[] = {1, 2, 3, 4};
+    const int data_b[] = {11, 12, 13};
+    const int pos_a = 1;
+    const int pos_b = 0;
+    const int result_a[] = {1, 11, 12, 13, 5};
+    const int result_b[] = {2, 3, 4};
+
+    linkedlist_t *list_a = linkedlist_create();
+    linkedlist_t *list_b = linkedlist_create();
+
+    list_populate(list_a, data_a, NB_ELEMENTS(data_a));
+    list_populate(list_b, data_b, NB_ELEMENTS(data_b));
+
+    linkedlist_cross(list_a, pos_a, list_b, pos_b);
+
+    // Adding checks that the tail followed the crossing.
+    int *added = malloc(sizeof (int));
+    *added = 5;
+    linkedlist_add(list_a, added);
+
+    list_read_to_array_reset();
+    linkedlist_run_for_all(list_a, list_read_to_array);
+    assert(int_arrays_equal(result_a, read_array, NB_ELEMENTS(result_a)));
+    assert(linkedlist_size_get(list_a) == NB_ELEMENTS(result_a));
+
+    list_read_to_array_reset();
+    linkedlist_run_for_all(list_b, list_read_to_array);
+    assert(int_arrays_equal(result_b, read_array, NB_ELEMENTS(result_b)));
+    assert(linkedlist_size_get(list_b) == NB_ELEMENTS(result_b));
+
+    linkedlist_destroy(list_a);
+    linkedlist_destroy(list_b);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_circular(void)
+{
+    TEST_START_PRINT();
+    const int data[] = {1, 2, 3, 4, 5, 6, 7};
+    const int result[] = {5, 6, 7};
+
+    linkedlist_t *list = linkedlist_circular_create(NB_ELEMENTS(result));
+    list_populate(list, data, NB_ELEMENTS(data));
+
+    assert(linkedlist_size_get(list) == NB_ELEMENTS(result));
+
+    list_read_to_array_reset();
+    linkedlist_run_for_all(list, list_read_to_array);
+    assert(int_arrays_equal(result, read_array, NB_ELEMENTS(result)));
+
+    // Copies, splits and crosses truncate to the capacity, and only what is
+    // kept counts against the budget.
+    linkedlist_t *long_list = linkedlist_create();
+    list_populate(long_list, data, NB_ELEMENTS(data));
+    linkedlist_data_size_set(long_list, sizeof data[0]);
+    linkedlist_data_size_set(list, sizeof data[0]);
+    size_t const full = linkedlist_memory_get(list);
+    linkedlist_budget_set(list, full);
+    assert(linkedlist_copy(list, long_list, sizeof data[0]) == LINKEDLIST_OK);
+    assert(linkedlist_size_get(list) == NB_ELEMENTS(result));
+    assert(linkedlist_memory_get(list) == full);
+    assert(*(int *) linkedlist_data_handle_get(list, 0) == data[0]);
+    assert(linkedlist_copy_many(&list, 1, long_list, sizeof data[0])
+           == LINKEDLIST_OK);
+    assert(linkedlist_size_get(list) == NB_ELEMENTS(result));
+    assert(linkedlist_split(long_list, 1, list) == LINKEDLIST_OK);
+    assert(linkedlist_size_get(list) == NB_ELEMENTS(result));
+    assert(*(int *) linkedlist_data_handle_get(list, 0) == data[1]);
+    list_populate(long_list, data, NB_ELEMENTS(data));
+    assert(linkedlist_cross(list, 1, long_list, 1) == LINKEDLIST_OK);
+    assert(linkedlist_size_get(list) == NB_ELEMENTS(result));
+    assert(linkedlist_memory_get(list) == full);
+
+    linkedlist_destroy(long_list);
+    linkedlist_destroy(list);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_pop_front(void)
+{
+    TEST_START_PRINT();
+    const int data[] = {1, 2, 3};
+
+    linkedlist_t *list = linkedlist_create();
+    list_populate(list, data, NB_ELEMENTS(data));
+
+    for (unsigned int i = 0; i < NB_ELEMENTS(data); i++) {
+        int *popped = linkedlist_pop_front(list);
+        assert(popped != NULL);
+        assert(*popped == data[i]);
+        free(popped);
+    }
+    assert(linkedlist_size_get(list) == 0);
+    assert(linkedlist_pop_front(list) == NULL);
+
+    // The emptied list is usable again.
+    list_populate(list, data, NB_ELEMENTS(data));
+    list_read_to_array_reset();
+    linkedlist_run_for_all(list, list_read_to_array);
+    assert(int_arrays_equal(data, read_array, NB_ELEMENTS(data)));
+
+    linkedlist_destroy(list);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_rotate(void)
+{
+    TEST_START_PRINT();
+    const int data[] = {1, 2, 3, 4, 5};
+    const int result_2[] = {3, 4, 5, 1, 2};
+    const int result_back[] = {2, 3, 4, 5, 1};
+
+    linkedlist_t *list = linkedlist_create();
+    list_populate(list, data, NB_ELEMENTS(data));
+
+    linkedlist_rotate(list, 2 + 3 * NB_ELEMENTS(data));
+    list_read_to_array_reset();
+    linkedlist_run_for_all(list, list_read_to_array);
+    assert(int_arrays_equal(result_2, read_array, NB_ELEMENTS(result_2)));
+
+    linkedlist_rotate(list, -1);
+    list_read_to_array_reset();
+    linkedlist_run_for_all(list, list_read_to_array);
+    assert(int_arrays_equal(result_back, read_array,
+                            NB_ELEMENTS(result_back)));
+
+    assert(*(int *) linkedlist_data_handle_get(list, 4) == 1);
+    assert(linkedlist_size_get(list) == NB_ELEMENTS(data));
+
+    linkedlist_destroy(list);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_view(void)
+{
+    TEST_START_PRINT();
+    const int data_a[] = {1, 2, 3, 4, 5};
+    const int data_b[] = {9, 3, 4, 9};
+    const int result[] = {3, 4};
+
+    linkedlist_t *list_a = linkedlist_create();
+    linkedlist_t *list_b = linkedlist_create();
+    list_populate(list_a, data_a, NB_ELEMENTS(data_a));
+    list_populate(list_b, data_b, NB_ELEMENTS(data_b));
+
+    linkedlist_view_t view_a;
+    linkedlist_view_t view_b;
+    linkedlist_view_init(&view_a, list_a, 2, 4);
+    linkedlist_view_init(&view_b, list_b, 1, 3);
+    assert(linkedlist_view_size_get(&view_a) == NB_ELEMENTS(result));
+
+    list_read_to_array_reset();
+    assert(linkedlist_view_run_for_all(&view_a, list_read_to_array)
+           == LINKEDLIST_OK);
+    assert(read_array_current_index == NB_ELEMENTS(result));
+    assert(int_arrays_equal(result, read_array, NB_ELEMENTS(result)));
+
+    assert(linkedlist_view_compare(&view_a, &view_b, sizeof data_a[0]));
+    assert(*(int *) linkedlist_view_data_handle_get(&view_a, 1) == 4);
+    assert(*(int *) linkedlist_view_data_handle_get(&view_a, 2) == 3);
+
+    // Copying out gives an independent list.
+    linkedlist_t *copy = linkedlist_create();
+    linkedlist_view_copy(copy, &view_a, sizeof data_a[0]);
+    assert(linkedlist_size_get(copy) == NB_ELEMENTS(result));
+    list_read_to_array_reset();
+    linkedlist_run_for_all(copy, list_read_to_array);
+    assert(int_arrays_equal(result, read_array, NB_ELEMENTS(result)));
+
+    // end is clamped to the list size.
+    linkedlist_view_init(&view_a, list_a, 3, 100);
+    assert(linkedlist_view_size_get(&view_a) == 2);
+
+    linkedlist_destroy(list_a);
+    linkedlist_destroy(list_b);
+    linkedlist_destroy(copy);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_concurrent(void)
+{
+    TEST_START_PRINT();
+    // More producers than fit, so that the max size is hit concurrently.
+    pthread_t threads[8];
+    const int per_thread = LINKEDLIST_MAX_SIZE / 4;
+
+    linkedlist_concurrent_t *list = linkedlist_concurrent_create();
+    assert(list != NULL);
+
+    for (unsigned int i = 0; i < NB_ELEMENTS(threads); i++) {
+        pthread_create(&threads[i], NULL, concurrent_producer, list);
+    }
+    for (unsigned int i = 0; i < NB_ELEMENTS(threads); i++) {
+        pthread_join(threads[i], NULL);
+    }
+    assert(linkedlist_concurrent_size_get(list) == LINKEDLIST_MAX_SIZE);
+
+    linkedlist_t *result = linkedlist_create();
+    int moved;
+    assert(linkedlist_concurrent_drain(list, result, &moved) == LINKEDLIST_OK);
+    assert(moved == LINKEDLIST_MAX_SIZE);
+    assert(linkedlist_size_get(result) == LINKEDLIST_MAX_SIZE);
+    assert(linkedlist_concurrent_size_get(list) == 0);
+
+    // Each producer's data keep their order.
+    int next_expected[NB_ELEMENTS(threads)] = {0};
+    for (int i = 0; i < LINKEDLIST_MAX_SIZE; i++) {
+        int const value = *(int *) linkedlist_data_handle_get(result, i);
+        int const thread = value / per_thread;
+        assert(value % per_thread >= next_expected[thread]);
+        next_expected[thread] = value % per_thread + 1;
+    }
+
+    // The drained list accepts more.
+    int *data = malloc(sizeof (int));
+    *data = 0;
+    assert(linkedlist_concurrent_add(list, data));
+    assert(linkedlist_concurrent_size_get(list) == 1);
+
+    // Data that dst cannot take stay in the list.
+    assert(linkedlist_concurrent_drain(list, result, &moved)
+           == LINKEDLIST_FULL);
+    assert(moved == 0);
+    assert(linkedlist_concurrent_size_get(list) == 1);
+    for (int i = 1; i < 5; i++) {
+        data = malloc(sizeof (int));
+        *data = i;
+        assert(linkedlist_concurrent_add(list, data));
+    }
+    linkedlist_t *budgeted = linkedlist_create();
+    linkedlist_data_size_set(budgeted, sizeof (int));
+    list_populate(budgeted, &next_expected[0], 1);
+    linkedlist_budget_set(budgeted, 3 * linkedlist_memory_get(budgeted));
+    assert(linkedlist_concurrent_drain(list, budgeted, &moved)
+           == LINKEDLIST_OVER_BUDGET);
+    assert(moved == 2);
+    assert(linkedlist_size_get(budgeted) == 3);
+    assert(linkedlist_concurrent_size_get(list) == 3);
+    assert(*(int *) linkedlist_data_handle_get(budgeted, 2) == 1);
+
+    linkedlist_destroy(budgeted);
+    linkedlist_destroy(result);
+    linkedlist_concurrent_destroy(list);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_status(void)
+{
+    TEST_START_PRINT();
+    int data = 0;
+    const gene_t gene = {1, 2};
+
+    linkedlist_last_error_clear();
+    linkedlist_log_hook_set(log_hook);
+
+    // Errors are also saved and logged, unless compiled out.
+    assert(linkedlist_add(NULL, &data) == LINKEDLIST_ERR_NULL);
+#ifndef LINKEDLIST_NO_DIAGNOSTICS
+    assert(linkedlist_last_error_get() == LINKEDLIST_ERR_NULL);
+    assert(hooked_status == LINKEDLIST_ERR_NULL);
+    assert(strcmp(hooked_func, "linkedlist_add") == 0);
+#endif
+
+    // Success does not reset the last error.
+    linkedlist_t *list = linkedlist_create();
+    assert(linkedlist_run_for_all(list, display) == LINKEDLIST_OK);
+#ifndef LINKEDLIST_NO_DIAGNOSTICS
+    assert(linkedlist_last_error_get() == LINKEDLIST_ERR_NULL);
+#endif
+    linkedlist_last_error_clear();
+    assert(linkedlist_last_error_get() == LINKEDLIST_OK);
+
+    // Being full is reported by status only.
+    hooked_status = LINKEDLIST_OK;
+    const int full_data[LINKEDLIST_MAX_SIZE] = {0};
+    list_populate(list, full_data, NB_ELEMENTS(full_data));
+    assert(linkedlist_add(list, &data) == LINKEDLIST_FULL);
+    assert(linkedlist_last_error_get() == LINKEDLIST_OK);
+    assert(hooked_status == LINKEDLIST_OK);
+
+    assert(linkedlist_size_get(NULL) == 0);
+#ifndef LINKEDLIST_NO_DIAGNOSTICS
+    assert(linkedlist_last_error_get() == LINKEDLIST_ERR_NULL);
+#endif
+
+    // The typed wrappers report their errors alike.
+    linkedlist_last_error_clear();
+    assert(genome_add(NULL, &gene) == LINKEDLIST_ERR_NULL);
+#ifndef LINKEDLIST_NO_DIAGNOSTICS
+    assert(linkedlist_last_error_get() == LINKEDLIST_ERR_NULL);
+    assert(strcmp(hooked_func, "genome_add") == 0);
+#else
+    assert(linkedlist_last_error_get() == LINKEDLIST_OK);
+#endif
+
+    linkedlist_log_hook_set(NULL);
+    linkedlist_last_error_clear();
+    linkedlist_destroy(list);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_typed(void)
+{
+    TEST_START_PRINT();
+    const gene_t data_a[] = {{1, 1}, {2, 2}, {3, 3}, {4, 4}};
+    const gene_t data_b[] = {{11, 0}, {12, 0}, {13, 0}};
+    const gene_t result_a[] = {{1, 1}, {12, 0}, {13, 0}};
+
+    genome_t *list_a = genome_create();
+    genome_t *list_b = genome_create();
+    for (unsigned int i = 0; i < NB_ELEMENTS(data_a); i++) {
+        assert(genome_add(list_a, &data_a[i]) == LINKEDLIST_OK);
+    }
+    for (unsigned int i = 0; i < NB_ELEMENTS(data_b); i++) {
+        assert(genome_add(list_b, &data_b[i]) == LINKEDLIST_OK);
+    }
+    assert(genome_size_get(list_a) == NB_ELEMENTS(data_a));
+    assert(genome_data_handle_get(list_a, 2)->a == 3);
+    assert(genome_data_handle_get(list_a, 2 + NB_ELEMENTS(data_a))->a == 3);
+
+    // Copy into a longer list, reusing its nodes.
+    genome_t *copy = genome_create();
+    genome_copy(copy, list_a);
+    genome_copy(copy, list_b);
+    assert(genome_compare(copy, list_b));
+    assert(!genome_compare(copy, list_a));
+
+    assert(genome_cross(list_a, 1, list_b, 1) == LINKEDLIST_OK);
+    assert(genome_size_get(list_a) == NB_ELEMENTS(result_a));
+    assert(genome_size_get(list_b) == 4);
+    for (unsigned int i = 0; i < NB_ELEMENTS(result_a); i++) {
+        gene_t const *gene = genome_data_handle_get(list_a, i);
+        assert(gene->a == result_a[i].a && gene->b == result_a[i].b);
+    }
+
+    // Round trip through the generic list.
+    linkedlist_t *generic = linkedlist_create();
+    assert(genome_to_linkedlist(generic, list_a) == LINKEDLIST_OK);
+    assert(linkedlist_size_get(generic) == NB_ELEMENTS(result_a));
+    assert(((gene_t *) linkedlist_data_handle_get(generic, 1))->a == 12);
+    genome_clear(copy);
+    linkedlist_view_t view;
+    linkedlist_view_init(&view, generic, 0, NB_ELEMENTS(result_a));
+    void * const head = linkedlist_data_handle_get(generic, 0);
+    assert(genome_from_linkedlist(copy, generic) == LINKEDLIST_OK);
+    assert(genome_compare(copy, list_a));
+    assert(((gene_t *) linkedlist_data_handle_get(generic, 0))->a == 1);
+
+    // The generic list is only read: its nodes and its views are unchanged.
+    assert(linkedlist_view_size_get(&view) == NB_ELEMENTS(result_a));
+    assert(linkedlist_view_data_handle_get(&view, 0) == head);
+
+    linkedlist_destroy(generic);
+    genome_destroy(copy);
+    genome_destroy(list_a);
+    genome_destroy(list_b);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_distance(void)
+{
+    TEST_START_PRINT();
+    const int data_a[] = {1, 2, 3, 4, 5};
+    const int data_b[] = {1, 0, 3, 0, 5};
+    const int data_c[] = {1, 2, 3};
+    // Pairwise distances between a, b, c.
+    const int result[] = {
+        0, 2, 2,
+        2, 0, 3,
+        2, 3, 0
+    };
+
+    linkedlist_t *lists[3];
+    for (unsigned int i = 0; i < NB_ELEMENTS(lists); i++) {
+        lists[i] = linkedlist_create();
+    }
+    list_populate(lists[0], data_a, NB_ELEMENTS(data_a));
+    list_populate(lists[1], data_b, NB_ELEMENTS(data_b));
+    list_populate(lists[2], data_c, NB_ELEMENTS(data_c));
+
+    int distance = -1;
+    assert(linkedlist_distance(lists[0], lists[1], sizeof data_a[0], &distance)
+           == LINKEDLIST_OK);
+    assert(distance == 2);
+    assert(linkedlist_distance(lists[2], lists[0], sizeof data_a[0], &distance)
+           == LINKEDLIST_OK);
+    assert(distance == 2);
+
+    int distances[NB_ELEMENTS(lists) * NB_ELEMENTS(lists)];
+    assert(linkedlist_distance_all_pairs(lists, NB_ELEMENTS(lists),
+                                         sizeof data_a[0], distances)
+           == LINKEDLIST_OK);
+    assert(int_arrays_equal(result, distances, NB_ELEMENTS(result)));
+
+    // Large payloads go through the vector kernels.
+    genome_t *genome_a = genome_create();
+    genome_t *genome_b = genome_create();
+    gene_t gene = {7, 7};
+    genome_add(genome_a, &gene);
+    genome_add(genome_b, &gene);
+    gene.b = 8;
+    genome_add(genome_a, &gene);
+    assert(genome_distance(genome_a, genome_b) == 1);
+    genome_add(genome_b, &gene);
+    assert(genome_distance(genome_a, genome_b) == 0);
+
+    linkedlist_t *big_a = linkedlist_create();
+    linkedlist_t *big_b = linkedlist_create();
+    const size_t big_size = 100;
+    for (int i = 0; i < 3; i++) {
+        char *big_data_a = calloc(big_size, 1);
+        char *big_data_b = calloc(big_size, 1);
+        // Differ in the 32-byte, 16-byte and memcmp parts of the kernel.
+        big_data_b[(size_t []) {5, 70, 99}[i]] = 1;
+        linkedlist_add(big_a, big_data_a);
+        linkedlist_add(big_b, big_data_b);
+    }
+    linkedlist_add(big_a, calloc(big_size, 1));
+    linkedlist_add(big_b, calloc(big_size, 1));
+    assert(linkedlist_distance(big_a, big_b, big_size, &distance)
+           == LINKEDLIST_OK);
+    assert(distance == 3);
+
+    linkedlist_destroy(big_a);
+    linkedlist_destroy(big_b);
+    genome_destroy(genome_a);
+    genome_destroy(genome_b);
+    for (unsigned int i = 0; i < NB_ELEMENTS(lists); i++) {
+        linkedlist_destroy(lists[i]);
+    }
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_copy_many(void)
+{
+    TEST_START_PRINT();
+    const int data[] = {1, 2, 3, 4, 5};
+    const int data_long[] = {11, 12, 13, 14, 15, 16, 17};
+    const int data_short[] = {21, 22};
+    const int result[] = {1, 2, 3, 4, 5, 6};
+
+    linkedlist_t *src = linkedlist_create();
+    list_populate(src, data, NB_ELEMENTS(data));
+
+    // Empty, longer and shorter destinations.
+    linkedlist_t *dsts[3];
+    for (unsigned int k = 0; k < NB_ELEMENTS(dsts); k++) {
+        dsts[k] = linkedlist_create();
+    }
+    list_populate(dsts[1], data_long, NB_ELEMENTS(data_long));
+    list_populate(dsts[2], data_short, NB_ELEMENTS(data_short));
+    int * const reused = linkedlist_data_handle_get(dsts[1], 0);
+
+    assert(linkedlist_copy_many(dsts, NB_ELEMENTS(dsts), src, sizeof data[0])
+           == LINKEDLIST_OK);
+
+    assert(linkedlist_data_handle_get(dsts[1], 0) == reused);
+    for (unsigned int k = 0; k < NB_ELEMENTS(dsts); k++) {
+        assert(linkedlist_compare(dsts[k], src, sizeof data[0]));
+        assert(linkedlist_size_get(dsts[k]) == NB_ELEMENTS(data));
+
+        // The tails are right.
+        int *added = malloc(sizeof (int));
+        *added = 6;
+        linkedlist_add(dsts[k], added);
+        list_read_to_array_reset();
+        linkedlist_run_for_all(dsts[k], list_read_to_array);
+        assert(int_arrays_equal(result, read_array, NB_ELEMENTS(result)));
+    }
+
+    // Copies do not share data with src.
+    *(int *) linkedlist_data_handle_get(src, 0) = 0;
+    assert(*(int *) linkedlist_data_handle_get(dsts[0], 0) == data[0]);
+
+    // The growth of a group is that of all its lists among dsts: one more node
+    // each fits in the budget for one list of the group, not for two.
+    size_t const per_node = linkedlist_memory_get(dsts[0])
+                            / NB_ELEMENTS(result);
+    size_t const memory = linkedlist_memory_get(dsts[0])
+                          + linkedlist_memory_get(dsts[2]);
+    linkedlist_group_t *group = linkedlist_group_create(memory + per_node);
+    linkedlist_group_set(dsts[0], group);
+    linkedlist_group_set(dsts[2], group);
+    linkedlist_t *src_long = linkedlist_create();
+    list_populate(src_long, data_long, NB_ELEMENTS(data_long));
+    assert(linkedlist_copy_many(dsts, NB_ELEMENTS(dsts), src_long,
+                                sizeof data[0]) == LINKEDLIST_OVER_BUDGET);
+    assert(linkedlist_size_get(dsts[0]) == NB_ELEMENTS(result));
+    linkedlist_group_set(dsts[2], NULL);
+    assert(linkedlist_copy_many(dsts, NB_ELEMENTS(dsts), src_long,
+                                sizeof data[0]) == LINKEDLIST_OK);
+    assert(linkedlist_group_memory_get(group)
+           == NB_ELEMENTS(data_long) * per_node);
+    linkedlist_group_set(dsts[0], NULL);
+    linkedlist_group_destroy(group);
+    linkedlist_destroy(src_long);
+
+    linkedlist_destroy(src);
+    for (unsigned int k = 0; k < NB_ELEMENTS(dsts); k++) {
+        linkedlist_destroy(dsts[k]);
+    }
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_memory(void)
+{
+    TEST_START_PRINT();
+    const int data[] = {1, 2, 3, 4};
+    size_t const total_before = linkedlist_memory_total_get();
+
+    linkedlist_t *list_a = linkedlist_create();
+    linkedlist_data_size_set(list_a, sizeof data[0]);
+    assert(linkedlist_memory_get(list_a) == 0);
+
+    list_populate(list_a, data, NB_ELEMENTS(data));
+    size_t const per_node = linkedlist_memory_get(list_a) / NB_ELEMENTS(data);
+    assert(per_node >= sizeof (int) + sizeof (void *));
+    assert(linkedlist_memory_get(list_a) == NB_ELEMENTS(data) * per_node);
+    assert(linkedlist_memory_total_get() - total_before
+           == NB_ELEMENTS(data) * per_node);
+
+    // Per list budget.
+    int one = 1;
+    linkedlist_budget_set(list_a, NB_ELEMENTS(data) * per_node);
+    assert(linkedlist_add(list_a, &one) == LINKEDLIST_OVER_BUDGET);
+    assert(linkedlist_size_get(list_a) == NB_ELEMENTS(data));
+    free(linkedlist_pop_front(list_a));
+    assert(linkedlist_memory_get(list_a) == (NB_ELEMENTS(data) - 1) * per_node);
+    linkedlist_budget_set(list_a, 0);
+
+    // Group budget, for two lists of 3 and 4 elements at most.
+    linkedlist_group_t *group = linkedlist_group_create(7 * per_node);
+    linkedlist_t *list_b = linkedlist_create();
+    linkedlist_group_set(list_a, group);
+    linkedlist_group_set(list_b, group);
+    assert(linkedlist_group_memory_get(group) == 3 * per_node);
+
+    assert(linkedlist_copy(list_b, list_a, sizeof data[0]) == LINKEDLIST_OK);
+    assert(linkedlist_group_memory_get(group) == 6 * per_node);
+    list_populate(list_b, data, 1);
+    assert(linkedlist_add(list_b, &one) == LINKEDLIST_OVER_BUDGET);
+
+    // Crossing within the group keeps its memory, so it is allowed.
+    assert(linkedlist_cross(list_a, 0, list_b, 3) == LINKEDLIST_OK);
+    assert(linkedlist_size_get(list_a) == 1);
+    assert(linkedlist_size_get(list_b) == 6);
+    assert(linkedlist_group_memory_get(group) == 7 * per_node);
+
+    // A list outside the group cannot push more into it.
+    linkedlist_t *list_c = linkedlist_create();
+    list_populate(list_c, data, NB_ELEMENTS(data));
+    linkedlist_data_size_set(list_c, sizeof data[0]);
+    assert(linkedlist_cross(list_a, 0, list_c, 0) == LINKEDLIST_OVER_BUDGET);
+    assert(linkedlist_size_get(list_a) == 1);
+    assert(linkedlist_cross(list_a, 0, list_c, 3) == LINKEDLIST_OK);
+
+    linkedlist_destroy(list_a);
+    linkedlist_destroy(list_b);
+    linkedlist_destroy(list_c);
+    linkedlist_group_destroy(group);
+    assert(linkedlist_memory_total_get() == total_before);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_group_threads(void)
+{
+    TEST_START_PRINT();
+    linkedlist_group_t *group = linkedlist_group_create(0);
+    pthread_t threads[4];
+
+    // Each thread works on its own list, all in the same group.
+    for (unsigned int i = 0; i < NB_ELEMENTS(threads); i++) {
+        pthread_create(&threads[i], NULL, group_worker, group);
+    }
+    for (unsigned int i = 0; i < NB_ELEMENTS(threads); i++) {
+        pthread_join(threads[i], NULL);
+    }
+    assert(linkedlist_group_memory_get(group) == 0);
+
+    linkedlist_group_destroy(group);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_concat_split(void)
+{
+    TEST_START_PRINT();
+    const int data_a[] = {1, 2, 3};
+    const int data_b[] = {4, 5, 6, 7};
+    const int result[] = {1, 2, 3, 4, 5, 6, 7, 8};
+
+    linkedlist_t *list_a = linkedlist_create();
+    linkedlist_t *list_b = linkedlist_create();
+    list_populate(list_a, data_a, NB_ELEMENTS(data_a));
+    list_populate(list_b, data_b, NB_ELEMENTS(data_b));
+    int * const moved_data = linkedlist_data_handle_get(list_b, 0);
+
+    assert(linkedlist_concat(list_a, list_b) == LINKEDLIST_OK);
+    assert(linkedlist_size_get(list_b) == 0);
+    assert(linkedlist_size_get(list_a) == 7);
+    assert(linkedlist_data_handle_get(list_a, 3) == moved_data);
+
+    // Both lists are still usable at their ends.
+    int *added = malloc(sizeof (int));
+    *added = 8;
+    linkedlist_add(list_a, added);
+    list_read_to_array_reset();
+    linkedlist_run_for_all(list_a, list_read_to_array);
+    assert(int_arrays_equal(result, read_array, NB_ELEMENTS(result)));
+    list_populate(list_b, data_a, 1);
+    assert(linkedlist_size_get(list_b) == 1);
+
+    // Split overwrites out, and moves the nodes without copying.
+    assert(linkedlist_split(list_a, 3, list_b) == LINKEDLIST_OK);
+    assert(linkedlist_size_get(list_a) == 3);
+    assert(linkedlist_size_get(list_b) == 5);
+    assert(linkedlist_data_handle_get(list_b, 0) == moved_data);
+    list_read_to_array_reset();
+    linkedlist_run_for_all(list_b, list_read_to_array);
+    assert(int_arrays_equal(&result[3], read_array, 5));
+
+    // Joining back gives the original list.
+    assert(linkedlist_concat(list_a, list_b) == LINKEDLIST_OK);
+    list_read_to_array_reset();
+    linkedlist_run_for_all(list_a, list_read_to_array);
+    assert(int_arrays_equal(result, read_array, NB_ELEMENTS(result)));
+
+    // Splitting at 0 moves everything, beyond the end nothing.
+    assert(linkedlist_split(list_a, 0, list_b) == LINKEDLIST_OK);
+    assert(linkedlist_size_get(list_a) == 0);
+    assert(linkedlist_size_get(list_b) == NB_ELEMENTS(result));
+    assert(linkedlist_split(list_b, 100, list_a) == LINKEDLIST_OK);
+    assert(linkedlist_size_get(list_b) == NB_ELEMENTS(result));
+
+    // Moved nodes keep the data size they are accounted with.
+    linkedlist_data_size_set(list_b, sizeof (int));
+    size_t const memory = linkedlist_memory_get(list_b);
+    assert(linkedlist_concat(list_a, list_b) == LINKEDLIST_OK);
+    assert(linkedlist_memory_get(list_a) == memory);
+    list_populate(list_b, data_a, 1);
+    linkedlist_data_size_set(list_b, 0);
+    assert(linkedlist_concat(list_a, list_b) == LINKEDLIST_ERR_MISMATCH);
+    assert(linkedlist_size_get(list_b) == 1);
+    assert(linkedlist_split(list_a, 1, list_b) == LINKEDLIST_OK);
+    assert(linkedlist_memory_get(list_a) + linkedlist_memory_get(list_b)
+           == memory);
+    assert(linkedlist_concat(list_a, list_b) == LINKEDLIST_OK);
+    assert(linkedlist_split(list_a, 0, list_b) == LINKEDLIST_OK);
+
+    // The max size holds.
+    const int data_long[LINKEDLIST_MAX_SIZE - 2] = {0};
+    list_populate(list_a, data_long, NB_ELEMENTS(data_long));
+    assert(linkedlist_concat(list_a, list_b) == LINKEDLIST_OK);
+    assert(linkedlist_size_get(list_a) == LINKEDLIST_MAX_SIZE);
+
+    linkedlist_destroy(list_a);
+    linkedlist_destroy(list_b);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_aggregate(void)
+{
+    TEST_START_PRINT();
+    const int data_a[] = {3, 1, 4, 1, 5, 9, 2, 6};
+    const int data_b[] = {10, 20, 30};
+    const int zero = 0;
+    const int min = -1000;
+    const linkedlist_aggregate_t sum = {sizeof (int), &zero, int_map, int_sum};
+    const linkedlist_aggregate_t max = {sizeof (int), &min, int_map, int_max};
+    int result;
+
+    linkedlist_t *list_a = linkedlist_create();
+    linkedlist_t *list_b = linkedlist_create();
+    assert(linkedlist_aggregate_get(list_a, 0, 1, &result)
+           == LINKEDLIST_ERR_NO_AGGREGATE);
+    list_populate(list_a, data_a, NB_ELEMENTS(data_a));
+    list_populate(list_b, data_b, NB_ELEMENTS(data_b));
+    assert(linkedlist_aggregate_set(list_a, &sum) == LINKEDLIST_OK);
+    assert(linkedlist_aggregate_set(list_b, &max) == LINKEDLIST_OK);
+
+    assert(linkedlist_aggregate_get(list_a, 0, 100, &result) == LINKEDLIST_OK);
+    assert(result == 31);
+    assert(linkedlist_aggregate_get(list_a, 2, 6, &result) == LINKEDLIST_OK);
+    assert(result == 19);
+    assert(linkedlist_aggregate_get(list_a, 3, 3, &result) == LINKEDLIST_OK);
+    assert(result == 0);
+    assert(linkedlist_aggregate_get(list_b, 0, 2, &result) == LINKEDLIST_OK);
+    assert(result == 20);
+
+    // Writes through a handle are accounted for once told.
+    *(int *) linkedlist_data_handle_get(list_a, 5) = 0;
+    assert(linkedlist_aggregate_update(list_a, 5) == LINKEDLIST_OK);
+    assert(list_sum(list_a, 0, 8) == 22);
+    assert(list_sum(list_a, 5, 6) == 0);
+
+    // Nodes changes are accounted for without telling.
+    list_populate(list_a, data_b, 1);
+    assert(list_sum(list_a, 0, 9) == 32);
+    assert(linkedlist_cross(list_a, 4, list_b, 1) == LINKEDLIST_OK);
+    assert(list_sum(list_a, 0, 100) == 3 + 1 + 4 + 1 + 20 + 30);
+    assert(linkedlist_aggregate_get(list_b, 0, 100, &result) == LINKEDLIST_OK);
+    assert(result == 10);
+    free(linkedlist_pop_front(list_a));
+    assert(list_sum(list_a, 0, 100) == 1 + 4 + 1 + 20 + 30);
+    assert(linkedlist_rotate(list_a, 2) == LINKEDLIST_OK);
+    assert(list_sum(list_a, 0, 2) == 1 + 20);
+
+    // Compare to the sum read from the list, over many changes.
+    const int data_long[100] = {[0] = 1, [50] = 2, [99] = 3};
+    for (int i = 0; i < 10; i++) {
+        list_populate(list_a, data_long, 10 * i);
+        assert(linkedlist_split(list_a, 7 * i, list_b) == LINKEDLIST_OK);
+        assert(linkedlist_concat(list_a, list_b) == LINKEDLIST_OK);
+        for (int start = 0; start < linkedlist_size_get(list_a); start += 13) {
+            int expected = 0;
+            for (int j = start; j < linkedlist_size_get(list_a); j++) {
+                expected += *(int *) linkedlist_data_handle_get(list_a, j);
+            }
+            assert(list_sum(list_a, start, 1000) == expected);
+        }
+    }
+
+    // Splices move the values along with the nodes, instead of mapping the
+    // data of all positions after the splice point again.
+    int data_many[4000];
+    for (int i = 0; i < 4000; i++) {
+        data_many[i] = i % 17;
+    }
+    linkedlist_t *many_a = linkedlist_create();
+    linkedlist_t *many_b = linkedlist_create();
+    assert(linkedlist_aggregate_set(many_a, &sum) == LINKEDLIST_OK);
+    assert(linkedlist_aggregate_set(many_b, &sum) == LINKEDLIST_OK);
+    list_populate(many_a, data_many, 4000);
+    list_populate(many_b, data_many, 1000);
+    assert(list_sum(many_a, 0, 4000) == 235 * 136 + 10);
+    assert(list_sum(many_b, 0, 1000) == 58 * 136 + 91);
+    int const expected_b = list_sum(many_b, 0, 900) + list_sum(many_a, 100,
+                                                              4000);
+    map_calls = 0;
+    assert(linkedlist_cross(many_a, 100, many_b, 900) == LINKEDLIST_OK);
+    assert(list_sum(many_b, 0, 5000) == expected_b);
+    assert(linkedlist_split(many_b, 2000, many_a) == LINKEDLIST_OK);
+    assert(linkedlist_concat(many_a, many_b) == LINKEDLIST_OK);
+    assert(linkedlist_rotate(many_a, 33) == LINKEDLIST_OK);
+    int const size_many = linkedlist_size_get(many_a);
+    for (int start = 0; start < size_many; start += 101) {
+        int const end = (start + 200 < size_many) ? start + 200 : size_many;
+        int expected = 0;
+        for (int j = start; j < end; j++) {
+            expected += *(int *) linkedlist_data_handle_get(many_a, j);
+        }
+        assert(list_sum(many_a, start, end) == expected);
+    }
+    assert(map_calls == 0);
+    linkedlist_destroy(many_a);
+    linkedlist_destroy(many_b);
+
+    // A sliding window and rotations move the nodes from front to back, so
+    // that the values are cut and joined.
+    linkedlist_t *window = linkedlist_circular_create(20);
+    assert(linkedlist_aggregate_set(window, &sum) == LINKEDLIST_OK);
+    for (int i = 0; i < 100; i++) {
+        list_populate(window, &i, 1);
+        if (i % 7 == 0) {
+            assert(linkedlist_rotate(window, i % 5 - 2) == LINKEDLIST_OK);
+        }
+        int const size = linkedlist_size_get(window);
+        for (int start = 0; start < size; start += 3) {
+            int expected = 0;
+            for (int j = start; j < size; j++) {
+                expected += *(int *) linkedlist_data_handle_get(window, j);
+                if (j % 4 == 0) {
+                    assert(list_sum(window, start, j + 1) == expected);
+                }
+            }
+            assert(list_sum(window, start, size) == expected);
+        }
+    }
+    linkedlist_destroy(window);
+
+    assert(linkedlist_aggregate_set(list_a, NULL) == LINKEDLIST_OK);
+    assert(linkedlist_aggregate_update(list_a, 0)
+           == LINKEDLIST_ERR_NO_AGGREGATE);
+    linkedlist_last_error_clear();
+    linkedlist_destroy(list_a);
+    linkedlist_destroy(list_b);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_fold(void)
+{
+    TEST_START_PRINT();
+    const int data[] = {4, 8, 15, 16, 23, 42};
+    linkedlist_t *list = linkedlist_create();
+    list_populate(list, data, NB_ELEMENTS(data));
+
+    // Collect to a local array, no global state.
+    int_array_t collected = {.nb = 0, .max = NB_ELEMENTS(data)};
+    assert(linkedlist_fold(list, int_collect, &collected) == LINKEDLIST_OK);
+    assert(collected.nb == NB_ELEMENTS(data));
+    assert(int_arrays_equal(data, collected.values, NB_ELEMENTS(data)));
+
+    // The fold stops when the callback returns false.
+    collected = (int_array_t) {.nb = 0, .max = 2};
+    assert(linkedlist_fold(list, int_collect, &collected) == LINKEDLIST_OK);
+    assert(collected.nb == 2);
+
+    // Searches stop at the first hit.
+    int_search_t search = {.value = 15, .visited = 0};
+    int position;
+    int *found = linkedlist_find_first(list, int_equals, &search, &position);
+    assert(found == linkedlist_data_handle_get(list, 2));
+    assert(position == 2);
+    assert(search.visited == 3);
+    search = (int_search_t) {.value = 5, .visited = 0};
+    assert(linkedlist_find_first(list, int_equals, &search, &position) == NULL);
+    assert(position == -1);
+    assert(search.visited == NB_ELEMENTS(data));
+
+    search = (int_search_t) {.value = 4, .visited = 0};
+    assert(linkedlist_any(list, int_equals, &search));
+    assert(search.visited == 1);
+    assert(!linkedlist_all(list, int_equals, &search));
+    assert(search.visited == 3);
+    assert(linkedlist_all(list, int_positive, NULL));
+
+    // Empty lists.
+    linkedlist_t *empty = linkedlist_create();
+    assert(!linkedlist_any(empty, int_positive, NULL));
+    assert(linkedlist_all(empty, int_positive, NULL));
+    assert(linkedlist_find_first(empty, int_positive, NULL, NULL) == NULL);
+
+    assert(linkedlist_fold(NULL, int_collect, NULL) == LINKEDLIST_ERR_NULL);
+    assert(!linkedlist_any(NULL, int_positive, NULL));
+    linkedlist_last_error_clear();
+    linkedlist_destroy(empty);
     linkedlist_destroy(list);
     TEST_END_PRINT();
 }
 
 
+static void test_linkedlist_intern(void)
+{
+    TEST_START_PRINT();
+    const int data_a[] = {1, 2, 3, 1};
+    const int data_d[] = {2, 5};
+    const int result[] = {1, 2, 5};
+    linkedlist_intern_t *table = linkedlist_intern_create(sizeof (int));
+    linkedlist_t *list_a = linkedlist_create();
+    linkedlist_t *list_b = linkedlist_create();
+    linkedlist_t *list_c = linkedlist_create();
+    linkedlist_t *list_d = linkedlist_create();
+    assert(linkedlist_intern_set(list_a, table) == LINKEDLIST_OK);
+    assert(linkedlist_intern_set(list_b, table) == LINKEDLIST_OK);
+
+    // Equal data added are shared.
+    list_populate(list_a, data_a, NB_ELEMENTS(data_a));
+    assert(linkedlist_intern_size_get(table) == 3);
+    assert(linkedlist_data_get(list_a, 0)
+           == linkedlist_data_get(list_a, 3));
+
+    // Copies share the data, unless not interning.
+    assert(linkedlist_copy(list_b, list_a, sizeof (int)) == LINKEDLIST_OK);
+    assert(linkedlist_copy(list_c, list_a, sizeof (int)) == LINKEDLIST_OK);
+    assert(linkedlist_intern_size_get(table) == 3);
+    for (int i = 0; i < NB_ELEMENTS(data_a); i++) {
+        assert(linkedlist_data_get(list_b, i)
+               == linkedlist_data_get(list_a, i));
+        assert(linkedlist_data_get(list_c, i)
+               != linkedlist_data_get(list_a, i));
+    }
+    assert(linkedlist_compare(list_a, list_b, sizeof (int)));
+    assert(linkedlist_compare(list_a, list_c, sizeof (int)));
+
+    // Data already in a list are moved to the table.
+    list_populate(list_d, data_d, NB_ELEMENTS(data_d));
+    assert(linkedlist_intern_set(list_d, table) == LINKEDLIST_OK);
+    assert(linkedlist_intern_size_get(table) == 4);
+    assert(linkedlist_data_get(list_d, 0)
+           == linkedlist_data_get(list_a, 1));
+
+    // Crossed nodes keep their data, popped data are copied for the caller.
+    assert(linkedlist_cross(list_b, 2, list_d, 1) == LINKEDLIST_OK);
+    list_read_to_array_reset();
+    linkedlist_run_for_all(list_b, list_read_to_array);
+    assert(int_arrays_equal(result, read_array, NB_ELEMENTS(result)));
+    int distance;
+    assert(linkedlist_distance(list_a, list_b, sizeof (int), &distance)
+           == LINKEDLIST_OK);
+    assert(distance == 2);
+    int *popped = linkedlist_pop_front(list_b);
+    assert(*popped == 1);
+    assert(popped != linkedlist_data_get(list_a, 0));
+    free(popped);
+
+    // Copies to several lists, interning or not.
+    linkedlist_t * const dsts[] = {list_b, list_c};
+    assert(linkedlist_copy_many(dsts, 2, list_d, sizeof (int))
+           == LINKEDLIST_OK);
+    assert(linkedlist_data_get(list_b, 1)
+           == linkedlist_data_get(list_d, 1));
+    assert(linkedlist_compare(list_c, list_d, sizeof (int)));
+    assert(linkedlist_sublist_copy(list_b, list_a, 2, sizeof (int))
+           == LINKEDLIST_OK);
+    assert(linkedlist_data_get(list_b, 1)
+           == linkedlist_data_get(list_a, 0));
+
+    // Writes copy shared data first, other lists are not changed.
+    const int value = 7;
+    assert(linkedlist_data_set(list_b, 0, &value, sizeof (int))
+           == LINKEDLIST_OK);
+    assert(*(int const *) linkedlist_data_get(list_b, 0) == 7);
+    assert(*(int const *) linkedlist_data_get(list_a, 2) == 3);
+    assert(linkedlist_intern_size_get(table) == 4);
+    int *handle = linkedlist_data_handle_get(list_b, 1);
+    assert(handle != linkedlist_data_get(list_a, 0));
+    *handle = 8;
+    assert(*(int const *) linkedlist_data_get(list_a, 0) == 1);
+    assert(linkedlist_intern_size_get(table) == 4);
+
+    // Reading keeps the data shared.
+    list_read_to_array_reset();
+    assert(linkedlist_run_for_all(list_d, list_read_to_array)
+           == LINKEDLIST_OK);
+    assert(read_array[1] == 3);
+    assert(linkedlist_data_get(list_d, 1) == linkedlist_data_get(list_a, 2));
+    assert(linkedlist_intern_size_get(table) == 4);
+
+    // Data are freed with their last reference, list_d still shares 3.
+    linkedlist_destroy(list_a);
+    assert(linkedlist_intern_size_get(table) == 4);
+    linkedlist_destroy(list_b);
+    assert(linkedlist_intern_size_get(table) == 3);
+
+    // Data of another size cannot be interned, NULL data are not shared.
+    linkedlist_data_size_set(list_c, sizeof (short));
+    assert(linkedlist_intern_set(list_c, table) == LINKEDLIST_ERR_MISMATCH);
+    linkedlist_last_error_clear();
+    linkedlist_data_size_set(list_c, sizeof (int));
+    assert(linkedlist_add(list_c, NULL) == LINKEDLIST_OK);
+    assert(linkedlist_intern_set(list_c, table) == LINKEDLIST_OK);
+    int const last = linkedlist_size_get(list_c) - 1;
+    assert(linkedlist_data_get(list_c, last) == NULL);
+    assert(linkedlist_copy(list_d, list_c, sizeof (int)) == LINKEDLIST_OK);
+    assert(linkedlist_data_get(list_d, last) == NULL);
+    assert(linkedlist_data_get(list_d, 0) == linkedlist_data_get(list_c, 0));
+
+    linkedlist_destroy(list_d);
+    linkedlist_destroy(list_c);
+    assert(linkedlist_intern_size_get(table) == 0);
+
+    // Interned data are charged once, lists interning them only their nodes,
+    // so that they fit in a budget that their copies would not.
+    const int same[10] = {0};
+    linkedlist_t *owned = linkedlist_create();
+    linkedlist_t *shared = linkedlist_create();
+    list_populate(owned, same, 1);
+    linkedlist_data_size_set(owned, sizeof (int));
+    size_t const node_memory = linkedlist_memory_get(owned) - sizeof (int);
+    assert(linkedlist_intern_set(shared, table) == LINKEDLIST_OK);
+    linkedlist_budget_set(shared, NB_ELEMENTS(same) * node_memory);
+    size_t const total = linkedlist_memory_total_get();
+    list_populate(shared, same, NB_ELEMENTS(same));
+    assert(linkedlist_size_get(shared) == NB_ELEMENTS(same));
+    assert(linkedlist_memory_get(shared) == NB_ELEMENTS(same) * node_memory);
+    assert(linkedlist_memory_total_get()
+           == total + NB_ELEMENTS(same) * node_memory + sizeof (int));
+    int * const over = malloc(sizeof (int));
+    *over = 0;
+    assert(linkedlist_add(shared, over) == LINKEDLIST_OVER_BUDGET);
+    free(over);
+    linkedlist_budget_set(shared, 0);
+    assert(linkedlist_intern_set(shared, NULL) == LINKEDLIST_OK);
+    assert(linkedlist_memory_get(shared)
+           == NB_ELEMENTS(same) * (node_memory + sizeof (int)));
+    linkedlist_destroy(shared);
+    linkedlist_destroy(owned);
+    assert(linkedlist_intern_size_get(table) == 0);
+    linkedlist_intern_destroy(table);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_intern_threads(void)
+{
+    TEST_START_PRINT();
+    const int data[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    linkedlist_intern_t *table = linkedlist_intern_create(sizeof (int));
+    linkedlist_t *parent = linkedlist_create();
+    linkedlist_intern_set(parent, table);
+    list_populate(parent, data, NB_ELEMENTS(data));
+    breeding_t breeding = {.parent = parent, .table = table};
+    pthread_t threads[4];
+
+    // Children of one parent, bred by several threads in one table.
+    for (unsigned int i = 0; i < NB_ELEMENTS(threads); i++) {
+        pthread_create(&threads[i], NULL, intern_breeder, &breeding);
+    }
+    for (unsigned int i = 0; i < NB_ELEMENTS(threads); i++) {
+        pthread_join(threads[i], NULL);
+    }
+    assert(linkedlist_intern_size_get(table) == NB_ELEMENTS(data));
+
+    linkedlist_destroy(parent);
+    assert(linkedlist_intern_size_get(table) == 0);
+    linkedlist_intern_destroy(table);
+    TEST_END_PRINT();
+}
+
+
+static void test_linkedlist_delta(void)
+{
+    TEST_START_PRINT();
+    const int data_from[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    const int data_tail[] = {10, 11, 12};
+    linkedlist_t *from = linkedlist_create();
+    linkedlist_t *to = linkedlist_create();
+    linkedlist_t *patched = linkedlist_create();
+    linkedlist_delta_t *delta = linkedlist_delta_create();
+    linkedlist_delta_t *delta_read = linkedlist_delta_create();
+    list_populate(from, data_from, NB_ELEMENTS(data_from));
+
+    // Equal lists give an empty delta.
+    linkedlist_copy(to, from, sizeof (int));
+    assert(linkedlist_diff(delta, from, to, sizeof (int)) == LINKEDLIST_OK);
+    assert(linkedlist_delta_size_get(delta) == 0);
+
+    // Changed positions and truncation.
+    *(int *) linkedlist_data_handle_get(to, 2) = 30;
+    *(int *) linkedlist_data_handle_get(to, 3) = 40;
+    linkedlist_t *cut = linkedlist_create();
+    linkedlist_split(to, 6, cut);
+    assert(linkedlist_diff(delta, from, to, sizeof (int)) == LINKEDLIST_OK);
+    assert(linkedlist_delta_size_get(delta) == 2);
+    linkedlist_copy(patched, from, sizeof (int));
+    assert(linkedlist_patch(patched, delta) == LINKEDLIST_OK);
+    assert(linkedlist_compare(patched, to, sizeof (int)));
+
+    // Appended tail, after one more change.
+    *(int *) linkedlist_data_handle_get(to, 5) = 60;
+    list_populate(to, data_tail, NB_ELEMENTS(data_tail));
+    assert(linkedlist_diff(delta, patched, to, sizeof (int)) == LINKEDLIST_OK);
+    assert(linkedlist_delta_size_get(delta) == 4);
+
+    // Patching a list of another size, or of other data, fails.
+    assert(linkedlist_patch(from, delta) == LINKEDLIST_ERR_MISMATCH);
+    linkedlist_data_size_set(patched, sizeof (short));
+    assert(linkedlist_patch(patched, delta) == LINKEDLIST_ERR_MISMATCH);
+    assert(linkedlist_size_get(patched) == 6);
+    linkedlist_data_size_set(patched, sizeof (int));
+    linkedlist_t *window = linkedlist_circular_create(8);
+    linkedlist_copy(window, patched, sizeof (int));
+    assert(linkedlist_patch(window, delta) == LINKEDLIST_ERR_MISMATCH);
+    assert(linkedlist_compare(window, patched, sizeof (int)));
+    linkedlist_destroy(window);
+
+    // Through a stream, two deltas after each other.
+    FILE *stream = tmpfile();
+    assert(stream != NULL);
+    linkedlist_delta_t *delta_back = linkedlist_delta_create();
+    assert(linkedlist_diff(delta_back, to, from, sizeof (int))
+           == LINKEDLIST_OK);
+    assert(linkedlist_delta_write(delta, stream) == LINKEDLIST_OK);
+    assert(linkedlist_delta_write(delta_back, stream) == LINKEDLIST_OK);
+    rewind(stream);
+    assert(linkedlist_delta_read(delta_read, stream) == LINKEDLIST_OK);
+    assert(linkedlist_delta_size_get(delta_read) == 4);
+    assert(linkedlist_patch(patched, delta_read) == LINKEDLIST_OK);
+    assert(linkedlist_compare(patched, to, sizeof (int)));
+    assert(linkedlist_delta_read(delta_read, stream) == LINKEDLIST_OK);
+    assert(linkedlist_patch(patched, delta_read) == LINKEDLIST_OK);
+    assert(linkedlist_compare(patched, from, sizeof (int)));
+
+    // The end of the stream, and malformed data, are detected.
+    assert(linkedlist_delta_read(delta_read, stream) == LINKEDLIST_ERR_IO);
+    assert(linkedlist_delta_size_get(delta_read) == 0);
+    rewind(stream);
+    fputs("LLD", stream);
+    rewind(stream);
+    assert(linkedlist_delta_read(delta_read, stream) == LINKEDLIST_OK);
+    rewind(stream);
+    fputs("XXXX", stream);
+    rewind(stream);
+    assert(linkedlist_delta_read(delta_read, stream) == LINKEDLIST_ERR_IO);
+
+    // Corrupt sizes are rejected before reserving the data: 4 GiB data, then
+    // 5000 data of 1 MiB, both followed by nothing.
+    unsigned char const huge_data[] = {
+        'L', 'L', 'D', 1, 0xF0, 0xFF, 0xFF, 0xFF, 0, 0, 0, 0, 1, 0, 0, 0,
+        1, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0
+    };
+    unsigned char const huge_payloads[] = {
+        'L', 'L', 'D', 1, 0, 0, 0x10, 0, 0, 0, 0, 0, 0x88, 0x13, 0, 0,
+        1, 0, 0, 0, 0, 0, 0, 0, 0x88, 0x13, 0, 0
+    };
+    rewind(stream);
+    fwrite(huge_data, 1, sizeof huge_data, stream);
+    fwrite(huge_payloads, 1, sizeof huge_payloads, stream);
+    rewind(stream);
+    assert(linkedlist_delta_read(delta_read, stream) == LINKEDLIST_ERR_IO);
+    fseek(stream, sizeof huge_data, SEEK_SET);
+    assert(linkedlist_delta_read(delta_read, stream) == LINKEDLIST_ERR_IO);
+    assert(linkedlist_delta_size_get(delta_read) == 0);
+    fclose(stream);
+    linkedlist_last_error_clear();
+
+    linkedlist_delta_destroy(delta);
+    linkedlist_delta_destroy(delta_back);
+    linkedlist_delta_destroy(delta_read);
+    linkedlist_destroy(from);
+    linkedlist_destroy(to);
+    linkedlist_destroy(cut);
+    linkedlist_destroy(patched);
+    TEST_END_PRINT();
+}
+
+
 //------------------------------------------------------------------------------
 // Helper functions
 //------------------------------------------------------------------------------
@@ -437,3 +1664,161 @@ static bool int_arrays_equal(int const * const a,
     }
     return true;
 }
+
+//  ----------------------------------------------------------------------------
+/// \brief  Add LINKEDLIST_MAX_SIZE / 4 values to a concurrent list. Each
+/// thread adds a distinct range of values, in increasing order. This function
+/// is meant to be used as a thread function.
+/// \param  list    The concurrent list to add to.
+//  ----------------------------------------------------------------------------
+static void *concurrent_producer(void *list)
+{
+    static int next_thread_index;
+    const int per_thread = LINKEDLIST_MAX_SIZE / 4;
+    int const first = __atomic_fetch_add(&next_thread_index, 1,
+                                         __ATOMIC_RELAXED) * per_thread;
+
+    for (int i = first; i < first + per_thread; i++) {
+        int *data = malloc(sizeof (int));
+        *data = i;
+        if (!linkedlist_concurrent_add(list, data)) {
+            free(data);
+        }
+    }
+    return NULL;
+}
+
+//  ----------------------------------------------------------------------------
+/// \brief  Save the reported error for inspection. This function is meant to
+/// be installed with linkedlist_log_hook_set().
+//  ----------------------------------------------------------------------------
+static void log_hook(linkedlist_status_t status, char const *func)
+{
+    hooked_status = status;
+    hooked_func = func;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Thread copying the parent list to a child in the same table, and
+/// mutating the child, many times.
+//  ----------------------------------------------------------------------------
+static void *intern_breeder(void *breeding)
+{
+    linkedlist_t * const parent = ((breeding_t *) breeding)->parent;
+    linkedlist_t *child = linkedlist_create();
+    linkedlist_intern_set(child, ((breeding_t *) breeding)->table);
+    for (int i = 0; i < 1000; i++) {
+        const int mutation = 100 + i % 10;
+        assert(linkedlist_copy(child, parent, sizeof (int)) == LINKEDLIST_OK);
+        assert(linkedlist_data_set(child, i, &mutation, sizeof (int))
+               == LINKEDLIST_OK);
+        assert(!linkedlist_compare(child, parent, sizeof (int)));
+    }
+    linkedlist_destroy(child);
+    return NULL;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Thread joining a list to the group, growing and shrinking it many
+/// times, and leaving the group.
+//  ----------------------------------------------------------------------------
+static void *group_worker(void *group)
+{
+    const int data[] = {1, 2, 3, 4, 5, 6, 7, 8};
+    linkedlist_t *list = linkedlist_create();
+    linkedlist_data_size_set(list, sizeof data[0]);
+    linkedlist_group_set(list, group);
+    for (int i = 0; i < 1000; i++) {
+        list_populate(list, data, NB_ELEMENTS(data));
+        for (unsigned int k = 0; k < NB_ELEMENTS(data); k++) {
+            free(linkedlist_pop_front(list));
+        }
+    }
+    linkedlist_group_set(list, NULL);
+    linkedlist_destroy(list);
+    return NULL;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Map of the int aggregates: the value is the data itself.
+//  ----------------------------------------------------------------------------
+static void int_map(void const * const data, void * const value)
+{
+    map_calls++;
+    *(int *) value = *(int const *) data;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Combine two int values by sum.
+//  ----------------------------------------------------------------------------
+static void int_sum(void const * const a, void const * const b,
+                    void * const result)
+{
+    *(int *) result = *(int const *) a + *(int const *) b;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Combine two int values by max.
+//  ----------------------------------------------------------------------------
+static void int_max(void const * const a, void const * const b,
+                    void * const result)
+{
+    int const x = *(int const *) a;
+    int const y = *(int const *) b;
+    *(int *) result = (x > y) ? x : y;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Get the aggregate of an int list, asserting that it succeeds.
+//  ----------------------------------------------------------------------------
+static int list_sum(linkedlist_t * const list, int const start,
+                    int const end)
+{
+    int result;
+    linkedlist_status_t const status = linkedlist_aggregate_get(list, start,
+                                                                end, &result);
+    assert(status == LINKEDLIST_OK);
+    (void) status;
+    return result;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Fold callback appending the int data to an int_array_t context.
+/// \return False when the max number of values is reached.
+//  ----------------------------------------------------------------------------
+static bool int_collect(void const * const data, void * const context)
+{
+    int_array_t * const array = context;
+    array->values[array->nb] = *(int const *) data;
+    array->nb++;
+    return array->nb < array->max;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Predicate comparing the int data to the value of an int_search_t
+/// context, counting calls.
+//  ----------------------------------------------------------------------------
+static bool int_equals(void const * const data, void * const context)
+{
+    int_search_t * const search = context;
+    search->visited++;
+    return *(int const *) data == search->value;
+}
+
+
+//  ----------------------------------------------------------------------------
+/// \brief  Predicate true for int data above 0, without context.
+//  ----------------------------------------------------------------------------
+static bool int_positive(void const * const data, void * const context)
+{
+    (void) context;
+    return *(int const *) data > 0;
+}